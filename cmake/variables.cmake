@@ -8,6 +8,11 @@ if(PROJECT_IS_TOP_LEVEL)
   option(startgit_DEVELOPER_MODE "Enable developer mode" OFF)
 endif()
 
+# ---- Instruction set ----
+
+# SSE2 is part of every x86-64 target, wider kernels have to be asked for
+option(startgit_AVX2 "Use AVX2 for the HTML escaping kernel" OFF)
+
 # ---- Warning guard ----
 
 # target_include_directories with the SYSTEM modifier will request the compiler
@@ -1,8 +0,0 @@
-#include "arguments.hpp"
-
-namespace startgit
-{
-
-arguments_t args = {};  // NOLINT
-
-}  // namespace startgit
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <charconv>
 #include <filesystem>
+#include <format>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -26,6 +30,56 @@ struct arguments_t
     }
   }
 
+  void set_diff_cache(std::string_view value)
+  {
+    diff_cache = to_number(value, 20U);  // MiB
+  }
+
+  void set_memory_budget(std::string_view value)
+  {
+    memory_budget = to_number(value, 20U);  // MiB
+  }
+
+  void set_diff_blob(std::string_view value)
+  {
+    diff_blob = to_number(value, 10U);  // KiB
+  }
+
+  void set_diff_lines(std::string_view value)
+  {
+    diff_lines = to_number(value);
+  }
+
+  void set_diff_files(std::string_view value)
+  {
+    diff_files = to_number(value);
+  }
+
+  void set_diff_page(std::string_view value)
+  {
+    diff_page = to_number(value, 20U);  // MiB
+  }
+
+  void set_file_size(std::string_view value)
+  {
+    file_size = to_number(value, 10U);  // KiB
+  }
+
+  void set_file_chunk(std::string_view value)
+  {
+    file_chunk = to_number(value);
+  }
+
+  void set_jobs(std::string_view value)
+  {
+    jobs = to_number(value);
+  }
+
+  void set_index_page(std::string_view value)
+  {
+    index_page = to_number(value);
+  }
+
   void set_base(std::string_view value)
   {
     base_url = value;
@@ -34,6 +88,23 @@ struct arguments_t
     }
   }
 
+  // the whole value has to be a number that still fits once scaled
+  // by 2^shift, e.g. from MiB to bytes
+  static std::size_t to_number(std::string_view value, unsigned shift = 0)
+  {
+    std::size_t res = 0;
+    const auto* end = value.data() + value.size();  // NOLINT
+    const auto [ptr, err] = std::from_chars(value.data(), end, res);
+
+    if (err != std::errc {} || ptr != end
+        || res > (std::numeric_limits<std::size_t>::max() >> shift))
+    {
+      throw std::runtime_error(std::format("invalid number '{}'", value));
+    }
+
+    return res << shift;
+  }
+
   std::filesystem::path output_dir = ".";
   std::vector<std::filesystem::path> repos;
   std::string resource_url = "https://dimitrijedobrota.com";
@@ -50,9 +121,19 @@ struct arguments_t
       "LICENSE.md",
       "README.md",
   };
+  std::size_t diff_cache = std::size_t {256} << 20U;  // NOLINT
+  std::size_t memory_budget = 0;
+  std::size_t diff_blob = std::size_t {1} << 20U;  // NOLINT
+  std::size_t diff_lines = 10000;  // NOLINT
+  std::size_t diff_files = 1000;  // NOLINT
+  std::size_t diff_page = std::size_t {16} << 20U;  // NOLINT
+  std::size_t file_size = std::size_t {1} << 20U;  // NOLINT
+  std::size_t file_chunk = 0;
+  std::size_t jobs = 1;
   bool force = false;
+  bool commit_graph = false;
+  std::size_t index_page = 100;  // NOLINT
+  bool index_owner = false;
 };
 
-extern arguments_t args;  // NOLINT
-
 }  // namespace startgit
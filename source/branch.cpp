@@ -3,31 +3,23 @@
 
 #include "branch.hpp"
 
+#include <git2wrap/error.hpp>
 #include <git2wrap/revwalk.hpp>
 
-#include "arguments.hpp"
-#include "repository.hpp"
-
 namespace startgit
 {
 
-branch::branch(git2wrap::branch brnch, repository& repo)
-    : m_branch(std::move(brnch))
+branch::branch(
+    git2wrap::branch brnch,
+    history::view commits,
+    const git2wrap::repository& repo,
+    const std::unordered_set<std::filesystem::path>& special
+)
+    : m_repo(&repo)
+    , m_branch(std::move(brnch))
     , m_name(m_branch.get_name())
+    , m_commits(commits)
 {
-  git2wrap::revwalk rwalk(repo.get());
-
-  const git2wrap::object obj = repo.get().revparse(m_name.c_str());
-  rwalk.push(obj.get_id());
-
-  while (auto commit = rwalk.next()) {
-    m_commits.emplace_back(std::move(commit));
-  }
-
-  if (m_commits.empty()) {
-    return;
-  }
-
   std::function<void(const git2wrap::tree&, const std::string& path)> traverse =
       [&](const auto& l_tree, const auto& path)
   {
@@ -50,21 +42,57 @@ branch::branch(git2wrap::branch brnch, repository& repo)
           continue;
       }
 
-      m_files.emplace_back(entry, full_path);
+      m_files.emplace_back(repo, entry, full_path);
+    }
+  };
 
-      if (!path.empty()) {
-        continue;
-      }
+  const auto tree = get_last_commit().get_tree();
+  traverse(tree, "");
+  m_special = find_special(repo, tree, special);
+}
 
-      auto itr = args.special.find(entry.get_name());
-      if (itr != args.special.end()) {
-        m_special.emplace_back(entry, *itr);
-      }
+std::vector<file> branch::find_special(
+    const git2wrap::repository& repo,
+    const git2wrap::tree& tree,
+    const std::unordered_set<std::filesystem::path>& special
+)
+{
+  std::vector<file> res;
+
+  for (size_t i = 0; i < tree.get_entrycount(); i++) {
+    const auto entry = tree.get_entry(i);
+    if (entry.get_type()() != git2wrap::object::object_type::blob()) {
+      continue;
     }
-  };
 
-  traverse(get_last_commit().get_tree(), "");
-  std::reverse(m_special.begin(), m_special.end());
+    auto itr = special.find(entry.get_name());
+    if (itr != special.end()) {
+      res.emplace_back(repo, entry, *itr);
+    }
+  }
+
+  std::reverse(res.begin(), res.end());
+  return res;
+}
+
+void branch::walk_commits_since(
+    const std::string& tip, const std::function<void(const commit&)>& proc
+) const
+{
+  git2wrap::revwalk rwalk(*m_repo);
+  rwalk.push(get_last_commit().get().get_id());
+
+  if (!tip.empty()) {
+    try {
+      rwalk.hide(m_repo->revparse(tip.c_str()).get_id());
+    } catch (const git2wrap::runtime_error& err) {
+      // previous tip no longer exists, walk everything
+    }
+  }
+
+  while (auto cmmt = rwalk.next()) {
+    proc(commit(std::move(cmmt)));
+  }
 }
 
 }  // namespace startgit
@@ -1,22 +1,30 @@
 #pragma once
 
+#include <filesystem>
+#include <functional>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <git2wrap/branch.hpp>
+#include <git2wrap/repository.hpp>
 
 #include "commit.hpp"
 #include "file.hpp"
+#include "history.hpp"
 
 namespace startgit
 {
 
-class repository;
-
 class branch
 {
 public:
-  explicit branch(git2wrap::branch brnch, repository& repo);
+  branch(
+      git2wrap::branch brnch,
+      history::view commits,
+      const git2wrap::repository& repo,
+      const std::unordered_set<std::filesystem::path>& special
+  );
   branch(const branch&) = delete;
   branch& operator=(const branch&) = delete;
   branch(branch&&) = default;
@@ -26,18 +34,32 @@ public:
   const auto& get() const { return m_branch; }
 
   const std::string& get_name() const { return m_name; }
-  const commit& get_last_commit() const { return m_commits[0]; }
+  const commit& get_last_commit() const { return m_commits.get_tip(); }
 
   const auto& get_commits() const { return m_commits; }
+
+  // visit the commits not reachable from tip, one at a time
+  void walk_commits_since(
+      const std::string& tip, const std::function<void(const commit&)>& proc
+  ) const;
+
   const auto& get_files() const { return m_files; }
   const auto& get_special() const { return m_special; }
 
+  // special files at the root of a tree, without walking the rest of it
+  static std::vector<file> find_special(
+      const git2wrap::repository& repo,
+      const git2wrap::tree& tree,
+      const std::unordered_set<std::filesystem::path>& special
+  );
+
 private:
+  const git2wrap::repository* m_repo;
   git2wrap::branch m_branch;
 
   std::string m_name;
 
-  std::vector<commit> m_commits;
+  history::view m_commits;
   std::vector<file> m_files;
   std::vector<file> m_special;
 };
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace startgit
+{
+
+// Least recently used cache keyed by object id, bounded by a byte budget.
+// Values report their own footprint through get_size(), the cache adds what
+// it spends on the key and its bookkeeping. Values are created outside of
+// the lock, so concurrent misses on different keys don't wait for each other.
+template<typename T>
+class lru_cache
+{
+public:
+  using value_ptr = std::shared_ptr<const T>;
+
+  explicit lru_cache(std::size_t budget)
+      : m_budget(budget)
+  {
+  }
+
+  void set_budget(std::size_t budget)
+  {
+    const std::lock_guard lock(m_mutex);
+    m_budget = budget;
+    trim();
+  }
+
+  template<typename F>
+  value_ptr get(const std::string& key, F make)
+  {
+    {
+      const std::lock_guard lock(m_mutex);
+      if (auto value = find(key)) {
+        return value;
+      }
+    }
+
+    value_ptr value = make();
+
+    const std::lock_guard lock(m_mutex);
+    if (auto other = find(key)) {
+      return other;  // created by another thread in the meantime
+    }
+
+    m_entries.push_front({key, value, value->get_size() + overhead(key)});
+    m_index.emplace(key, m_entries.begin());
+    m_used += m_entries.front().size;
+
+    trim();
+    return value;
+  }
+
+private:
+  struct entry
+  {
+    std::string key;
+    value_ptr value;
+    std::size_t size;
+  };
+
+  // list and index nodes, both copies of the key, the index bucket and
+  // the control block make_shared allocates next to the value
+  static std::size_t overhead(const std::string& key)
+  {
+    static const std::size_t inline_size = std::string().capacity();
+    static constexpr std::size_t pointer = sizeof(void*);
+    static constexpr std::size_t control = 2 * pointer;
+
+    const std::size_t heap = key.size() > inline_size ? key.size() + 1 : 0;
+    const std::size_t list_node = sizeof(entry) + (2 * pointer);
+    const std::size_t index_node = sizeof(std::string)
+        + sizeof(typename std::list<entry>::iterator) + (3 * pointer);
+
+    return list_node + index_node + (2 * heap) + pointer + control;
+  }
+
+  value_ptr find(const std::string& key)
+  {
+    const auto itr = m_index.find(key);
+    if (itr == m_index.end()) {
+      return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, itr->second);
+    return itr->second->value;
+  }
+
+  void trim()
+  {
+    // the most recent entry is kept even if it alone is over budget
+    while (m_used > m_budget && m_entries.size() > 1) {
+      m_used -= m_entries.back().size;
+      m_index.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+  }
+
+  std::mutex m_mutex;
+
+  std::size_t m_budget;
+  std::size_t m_used = 0;
+
+  std::list<entry> m_entries;
+  std::unordered_map<std::string, typename std::list<entry>::iterator> m_index;
+};
+
+}  // namespace startgit
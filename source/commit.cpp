@@ -10,10 +10,28 @@ namespace startgit
 
 commit::commit(git2wrap::commit cmmt)
     : m_commit(std::move(cmmt))
-    , m_diff(m_commit)
 {
 }
 
+std::unique_ptr<diff> commit::get_diff(const arguments_t& args) const
+{
+  return std::make_unique<diff>(m_commit, args.diff_blob);
+}
+
+std::shared_ptr<const diff_stats> commit::get_stats(
+    const arguments_t& args
+) const
+{
+  // counts only depend on the commit, whichever handle computes them
+  return diff_cache().get(
+      get_id(),
+      [&]()
+      {
+        return std::make_shared<const diff_stats>(get_diff(args)->get_stats());
+      }
+  );
+}
+
 std::string commit::get_id() const
 {
   return m_commit.get_id().get_hex_string(shasize);
@@ -74,6 +92,11 @@ git2wrap::tree commit::get_tree() const
   return m_commit.get_tree();
 }
 
+std::string commit::get_tree_id() const
+{
+  return m_commit.get_tree().get_id().get_hex_string(shasize);
+}
+
 std::string commit::get_message() const
 {
   return m_commit.get_message();
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
+
 #include <git2wrap/commit.hpp>
 #include <git2wrap/tree.hpp>
 
+#include "arguments.hpp"
 #include "diff.hpp"
 
 namespace startgit
@@ -14,7 +17,9 @@ public:
   explicit commit(git2wrap::commit cmmt);
 
   const auto& get() const { return m_commit; }
-  const diff& get_diff() const { return m_diff; }
+  // a new diff on the handle of this commit, never shared between threads
+  std::unique_ptr<diff> get_diff(const arguments_t& args) const;
+  std::shared_ptr<const diff_stats> get_stats(const arguments_t& args) const;
 
   std::string get_id() const;
   std::string get_parent_id() const;
@@ -26,13 +31,13 @@ public:
   std::string get_author_name() const;
   std::string get_author_email() const;
   git2wrap::tree get_tree() const;
+  std::string get_tree_id() const;
   std::string get_message() const;
 
 private:
   static const int shasize = 40;
 
   git2wrap::commit m_commit;
-  diff m_diff;
 };
 
 }  // namespace startgit
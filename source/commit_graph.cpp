@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "commit_graph.hpp"
+
+#include <fcntl.h>
+#include <git2/sys/commit_graph.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace startgit
+{
+
+namespace
+{
+
+// see Documentation/gitformat-commit-graph.txt in git
+constexpr std::uint32_t sig_graph = 0x43475048;  // CGPH
+constexpr std::uint32_t chunk_fanout = 0x4f494446;  // OIDF
+constexpr std::uint32_t chunk_lookup = 0x4f49444c;  // OIDL
+constexpr std::uint32_t chunk_data = 0x43444154;  // CDAT
+constexpr std::uint32_t chunk_edges = 0x45444745;  // EDGE
+
+constexpr std::uint32_t parent_none = 0x70000000;
+constexpr std::uint32_t parent_extra = 0x80000000;
+constexpr std::uint32_t parent_mask = 0x7fffffff;
+
+constexpr std::size_t header_size = 8;
+constexpr std::size_t chunk_entry = 12;
+constexpr std::size_t fanout_size = 256 * 4;
+
+std::uint32_t read32(const unsigned char* ptr)
+{
+  // NOLINTBEGIN
+  return (std::uint32_t {ptr[0]} << 24U) | (std::uint32_t {ptr[1]} << 16U)
+      | (std::uint32_t {ptr[2]} << 8U) | std::uint32_t {ptr[3]};
+  // NOLINTEND
+}
+
+std::uint64_t read64(const unsigned char* ptr)
+{
+  return (std::uint64_t {read32(ptr)} << 32U) | read32(ptr + 4);  // NOLINT
+}
+
+}  // namespace
+
+std::filesystem::path commit_graph::objects_dir(
+    const git2wrap::repository& repo
+)
+{
+  return std::filesystem::path(git_repository_path(repo.get())) / "objects";
+}
+
+commit_graph::commit_graph(const git2wrap::repository& repo)
+    : commit_graph(objects_dir(repo) / "info")
+{
+}
+
+commit_graph::commit_graph(const std::filesystem::path& info)
+{
+  // a single graph file takes precedence, as it does for git
+  if (load(info / "commit-graph")) {
+    return;
+  }
+
+  const auto dir = info / "commit-graphs";
+  std::ifstream chain(dir / "commit-graph-chain");
+
+  std::string hash;
+  while (std::getline(chain, hash)) {
+    if (!load(dir / ("graph-" + hash + ".graph"))) {
+      // a broken link makes everything above it unusable
+      break;
+    }
+  }
+}
+
+commit_graph::~commit_graph()
+{
+  for (const auto& lay : m_layers) {
+    ::munmap(lay.map, lay.map_size);
+  }
+}
+
+bool commit_graph::load(const std::filesystem::path& path)
+{
+  const int fdes = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT
+  if (fdes == -1) {
+    return false;
+  }
+
+  layer lay;
+
+  struct stat stt = {};
+  if (::fstat(fdes, &stt) == 0 && stt.st_size > 0) {
+    lay.map_size = static_cast<std::size_t>(stt.st_size);
+    lay.map = ::mmap(nullptr, lay.map_size, PROT_READ, MAP_PRIVATE, fdes, 0);
+  }
+  ::close(fdes);
+
+  if (lay.map == nullptr || lay.map == MAP_FAILED) {  // NOLINT
+    return false;
+  }
+
+  const auto* base = static_cast<const unsigned char*>(lay.map);
+  const auto size = lay.map_size;
+
+  const auto fail = [&]()
+  {
+    ::munmap(lay.map, lay.map_size);
+    return false;
+  };
+
+  // version 1, sha1 only
+  if (size < header_size || read32(base) != sig_graph || base[4] != 1
+      || base[5] != 1)  // NOLINT
+  {
+    return fail();
+  }
+
+  const std::size_t chunks = base[6];  // NOLINT
+  if (size < header_size + ((chunks + 1) * chunk_entry)) {
+    return fail();
+  }
+
+  // a chunk runs up to where the next one starts, the table is closed
+  // by an extra entry holding the end of the last chunk
+  std::size_t fanout_end = 0;
+  std::size_t oids_end = 0;
+  std::size_t data_end = 0;
+  std::size_t edges_end = 0;
+
+  for (std::size_t i = 0; i < chunks; i++) {
+    const auto* entry = base + header_size + (i * chunk_entry);  // NOLINT
+    const auto offset = read64(entry + 4);  // NOLINT
+    const auto next = read64(entry + chunk_entry + 4);  // NOLINT
+    if (offset > next || next > size) {
+      return fail();
+    }
+
+    const auto* chunk = base + offset;  // NOLINT
+    switch (read32(entry)) {
+      case chunk_fanout:
+        lay.fanout = chunk;
+        fanout_end = next;
+        break;
+      case chunk_lookup:
+        lay.oids = chunk;
+        oids_end = next;
+        break;
+      case chunk_data:
+        lay.data = chunk;
+        data_end = next;
+        break;
+      case chunk_edges:
+        lay.edges = chunk;
+        edges_end = next;
+        break;
+      default:
+        break;
+    }
+  }
+
+  const auto extent = [&](const unsigned char* chunk, std::size_t end)
+  { return end - static_cast<std::size_t>(chunk - base); };
+
+  if (lay.fanout == nullptr || lay.oids == nullptr || lay.data == nullptr
+      || extent(lay.fanout, fanout_end) < fanout_size)
+  {
+    return fail();
+  }
+
+  lay.count = read32(lay.fanout + fanout_size - 4);  // NOLINT
+  lay.base = m_count;
+
+  // lookups trust the fanout to stay within the oid chunk
+  for (std::size_t i = 0, prev = 0; i < fanout_size; i += 4) {
+    const auto crnt = read32(lay.fanout + i);  // NOLINT
+    if (crnt < prev || crnt > lay.count) {
+      return fail();
+    }
+    prev = crnt;
+  }
+
+  const auto count = std::size_t {lay.count};
+  if (extent(lay.oids, oids_end) < count * hash_size
+      || extent(lay.data, data_end) < count * data_size
+      || std::size_t {m_count} + count > parent_mask)
+  {
+    return fail();
+  }
+
+  if (lay.edges != nullptr) {
+    lay.edge_count = extent(lay.edges, edges_end) / 4;
+  }
+
+  m_count += lay.count;
+  m_layers.push_back(lay);
+  return true;
+}
+
+const commit_graph::layer& commit_graph::get_layer(std::uint32_t pos) const
+{
+  const auto itr = std::upper_bound(
+      m_layers.begin(),
+      m_layers.end(),
+      pos,
+      [](auto val, const auto& lay) { return val < lay.base; }
+  );
+
+  return *std::prev(itr);
+}
+
+const unsigned char* commit_graph::get_data(std::uint32_t pos) const
+{
+  const auto& lay = get_layer(pos);
+  return lay.data + (std::size_t {pos - lay.base} * data_size);  // NOLINT
+}
+
+std::optional<std::uint32_t> commit_graph::find(const git2wrap::oid& oid) const
+{
+  const auto* key = oid.ptr()->id;
+  const auto first = key[0];  // NOLINT
+
+  for (const auto& lay : m_layers) {
+    std::uint32_t low =
+        first == 0 ? 0 : read32(lay.fanout + ((first - 1) * 4));  // NOLINT
+    std::uint32_t high = read32(lay.fanout + (first * 4));  // NOLINT
+
+    while (low < high) {
+      const auto mid = low + ((high - low) / 2);
+      const auto* crnt = lay.oids + (std::size_t {mid} * hash_size);  // NOLINT
+
+      const int cmp = std::memcmp(crnt, key, hash_size);
+      if (cmp == 0) {
+        return lay.base + mid;
+      }
+
+      if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+  }
+
+  return {};
+}
+
+git2wrap::oid commit_graph::get_id(std::uint32_t pos) const
+{
+  const auto& lay = get_layer(pos);
+
+  git_oid raw = {};
+  std::memcpy(
+      raw.id,
+      lay.oids + (std::size_t {pos - lay.base} * hash_size),  // NOLINT
+      hash_size
+  );
+  return git2wrap::oid(&raw);
+}
+
+std::int64_t commit_graph::get_time(std::uint32_t pos) const
+{
+  // top 30 bits are the generation, the remaining 34 the commit time
+  const auto* data = get_data(pos) + hash_size + 8;  // NOLINT
+  const auto high = std::uint64_t {read32(data) & 0x3U};  // NOLINT
+  return static_cast<std::int64_t>((high << 32U) | read32(data + 4));  // NOLINT
+}
+
+bool commit_graph::get_parents(
+    std::uint32_t pos, std::vector<std::uint32_t>& out
+) const
+{
+  out.clear();
+
+  const auto* data = get_data(pos) + hash_size;  // NOLINT
+
+  const auto add = [&](std::uint32_t parent)
+  {
+    out.push_back(parent);
+    return parent < m_count;
+  };
+
+  const auto first = read32(data);
+  if (first == parent_none) {
+    return true;
+  }
+
+  if (!add(first)) {
+    return false;
+  }
+
+  const auto second = read32(data + 4);  // NOLINT
+  if (second == parent_none) {
+    return true;
+  }
+
+  if ((second & parent_extra) == 0) {
+    return add(second);
+  }
+
+  // octopus merges list the rest of their parents in the edge chunk
+  const auto& lay = get_layer(pos);
+  for (std::size_t idx = second & parent_mask; idx < lay.edge_count; idx++) {
+    const auto val = read32(lay.edges + (idx * 4));  // NOLINT
+    if (!add(val & parent_mask)) {
+      return false;
+    }
+
+    if ((val & parent_extra) != 0) {
+      return true;
+    }
+  }
+
+  // the list ran past the end of the chunk, or there is no chunk at all
+  return false;
+}
+
+bool commit_graph::write(const git2wrap::repository& repo)
+{
+  const auto info = objects_dir(repo) / "info";
+
+  git_commit_graph_writer* writer = nullptr;
+  git_revwalk* walk = nullptr;
+
+  const bool res = git_commit_graph_writer_new(&writer, info.c_str(), nullptr)
+          == 0
+      && git_revwalk_new(&walk, repo.get()) == 0
+      && git_revwalk_push_glob(walk, "refs/heads/*") == 0
+      && git_commit_graph_writer_add_revwalk(writer, walk) == 0
+      && git_commit_graph_writer_commit(writer) == 0;
+
+  git_revwalk_free(walk);
+  git_commit_graph_writer_free(writer);
+
+  return res;
+}
+
+}  // namespace startgit
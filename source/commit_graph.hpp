@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include <git2wrap/oid.hpp>
+#include <git2wrap/repository.hpp>
+
+namespace startgit
+{
+
+// Read only view of the commit-graph files git keeps in objects/info.
+// Parents, trees and commit times come straight from the mapped file,
+// without inflating any commit. A chain of split graphs is read as one,
+// positions of all layers are numbered from the base layer up.
+class commit_graph
+{
+public:
+  explicit commit_graph(const git2wrap::repository& repo);
+
+  // the graphs in an objects/info directory
+  explicit commit_graph(const std::filesystem::path& info);
+
+  commit_graph(const commit_graph&) = delete;
+  commit_graph& operator=(const commit_graph&) = delete;
+  commit_graph(commit_graph&&) = delete;
+  commit_graph& operator=(commit_graph&&) = delete;
+  ~commit_graph();
+
+  std::optional<std::uint32_t> find(const git2wrap::oid& oid) const;
+
+  git2wrap::oid get_id(std::uint32_t pos) const;
+  std::int64_t get_time(std::uint32_t pos) const;
+
+  // false if the graph points outside of itself, the commit has to be
+  // looked up instead
+  bool get_parents(std::uint32_t pos, std::vector<std::uint32_t>& out) const;
+
+  // write or refresh the graph with everything reachable from a branch
+  static bool write(const git2wrap::repository& repo);
+
+private:
+  static constexpr std::size_t hash_size = 20;
+  static constexpr std::size_t data_size = hash_size + 16;
+
+  struct layer
+  {
+    void* map = nullptr;
+    std::size_t map_size = 0;
+
+    const unsigned char* fanout = nullptr;
+    const unsigned char* oids = nullptr;
+    const unsigned char* data = nullptr;
+    const unsigned char* edges = nullptr;
+
+    std::uint32_t count = 0;
+    std::size_t edge_count = 0;
+    std::uint32_t base = 0;
+  };
+
+  static std::filesystem::path objects_dir(const git2wrap::repository& repo);
+
+  bool load(const std::filesystem::path& path);
+  const layer& get_layer(std::uint32_t pos) const;
+  const unsigned char* get_data(std::uint32_t pos) const;
+
+  std::vector<layer> m_layers;
+  std::uint32_t m_count = 0;
+};
+
+}  // namespace startgit
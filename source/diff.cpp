@@ -1,11 +1,12 @@
+#include <utility>
+
 #include "diff.hpp"
 
 namespace startgit
 {
 
-diff::diff(const git2wrap::commit& cmmt)
+diff::diff(const git2wrap::commit& cmmt, std::size_t max_size)
     : m_diff(nullptr, nullptr)
-    , m_stats(nullptr)
 {
   const auto ptree = cmmt.get_parentcount() > 0
       ? cmmt.get_parent().get_tree()
@@ -16,75 +17,116 @@ diff::diff(const git2wrap::commit& cmmt)
   using flag = git2wrap::diff_options::flag;
   opts.flags() = flag::disable_pathspec_match | flag::ignore_submodules
       | flag::include_typechange;
+  opts.max_size() = static_cast<git2wrap::object_size_t>(max_size);
 
   m_diff = git2wrap::diff::tree_to_tree(ptree, cmmt.get_tree(), opts);
-  m_stats = m_diff.get_stats();
+
+  const auto count = git_diff_num_deltas(m_diff.get());
+  m_deltas.reserve(count);
+  for (std::size_t i = 0; i < count; i++) {
+    m_deltas.emplace_back(git_diff_get_delta(m_diff.get(), i));
+  }
+}
+
+diff_stats diff::get_stats() const
+{
+  const auto stats = m_diff.get_stats();
+  return {
+      stats.get_files_changed(),
+      stats.get_insertions(),
+      stats.get_deletions(),
+  };
+}
+
+void diff::load(std::size_t idx)
+{
+  auto& dlt = m_deltas[idx];
+  if (std::exchange(dlt.m_loaded, true)) {
+    return;
+  }
+
+  git_patch* patch = nullptr;
+  if (git_patch_from_diff(&patch, m_diff.get(), idx) != 0 || patch == nullptr)
+  {
+    return;
+  }
+  dlt.m_patch.reset(patch);
+
+  std::size_t adds = 0;
+  std::size_t dels = 0;
+  git_patch_line_stats(nullptr, &adds, &dels, patch);
+
+  dlt.m_size = git_patch_size(patch, 1, 0, 0);
+  dlt.m_adds = static_cast<uint32_t>(adds);
+  dlt.m_dels = static_cast<uint32_t>(dels);
+  m_insertions += adds;
+  m_deletions += dels;
 }
 
-const std::vector<delta>& diff::get_deltas() const
+void delta::visit(const visitor& vis) const
 {
-  if (!m_deltas.empty()) {
-    return m_deltas;
+  auto* patch = m_patch.get();
+  if (patch == nullptr) {
+    return;
   }
 
-  m_diff.foreach(
-      file_cb, nullptr, hunk_cb, line_cb, const_cast<diff*>(this)  // NOLINT
-  );
+  for (std::size_t i = 0; i < git_patch_num_hunks(patch); i++) {
+    const git_diff_hunk* hunk = nullptr;
+    std::size_t lines = 0;
+    if (git_patch_get_hunk(&hunk, &lines, patch, i) != 0) {
+      continue;
+    }
+    vis.on_hunk(*hunk);
 
-  for (auto& delta : m_deltas) {
-    for (const auto& hunk : delta.get_hunks()) {
-      for (const auto& line : hunk.get_lines()) {
-        delta.m_adds += static_cast<uint32_t>(line.is_add());
-        delta.m_dels += static_cast<uint32_t>(line.is_del());
+    for (std::size_t j = 0; j < lines; j++) {
+      const git_diff_line* line = nullptr;
+      if (git_patch_get_line_in_hunk(&line, patch, i, j) == 0) {
+        vis.on_line(*line);
       }
     }
   }
-  return m_deltas;
 }
 
-int diff::file_cb(
-    const git_diff_delta* delta, float /* progress */, void* payload
-)
+lru_cache<diff_stats>& diff_cache()
 {
-  diff& crnt = *reinterpret_cast<diff*>(payload);  // NOLINT
-  crnt.m_deltas.emplace_back(delta);
-  return 0;
+  static const std::size_t default_budget = std::size_t {256} << 20U;
+  static lru_cache<diff_stats> cache(default_budget);
+  return cache;
 }
 
-int diff::hunk_cb(
-    const git_diff_delta* /* delta */, const git_diff_hunk* hunk, void* payload
+tree_changes::tree_changes(
+    const git2wrap::tree& old_tree, const git2wrap::tree& new_tree
 )
 {
-  diff& crnt = *reinterpret_cast<diff*>(payload);  // NOLINT
-  crnt.m_deltas.back().m_hunks.emplace_back(hunk);
-  return 0;
-}
+  git2wrap::diff_options opts;
 
-int diff::line_cb(
-    const git_diff_delta* /* delta */,
-    const git_diff_hunk* /* hunk */,
-    const git_diff_line* line,
-    void* payload
-)
-{
-  diff& crnt = *reinterpret_cast<diff*>(payload);  // NOLINT
-  crnt.m_deltas.back().m_hunks.back().m_lines.emplace_back(line);
-  return 0;
-}
+  using flag = git2wrap::diff_options::flag;
+  opts.flags() = flag::disable_pathspec_match | flag::ignore_submodules
+      | flag::include_typechange;
 
-std::string diff::get_files_changed() const
-{
-  return std::to_string(m_stats.get_files_changed());
+  const auto dif = git2wrap::diff::tree_to_tree(old_tree, new_tree, opts);
+  dif.foreach(file_cb, nullptr, nullptr, nullptr, this);
 }
 
-std::string diff::get_insertions() const
+int tree_changes::file_cb(
+    const git_diff_delta* delta, float /* progress */, void* payload
+)
 {
-  return std::to_string(m_stats.get_insertions());
-}
+  auto& crnt = *reinterpret_cast<tree_changes*>(payload);  // NOLINT
 
-std::string diff::get_deletions() const
-{
-  return std::to_string(m_stats.get_deletions());
+  switch (delta->status) {
+    case GIT_DELTA_ADDED:
+      crnt.added.emplace(delta->new_file.path);
+      break;
+    case GIT_DELTA_DELETED:
+      crnt.deleted.emplace_back(delta->old_file.path);
+      break;
+    default:
+      crnt.modified.emplace(delta->new_file.path);
+      break;
+  }
+
+  return 0;
 }
 
 }  // namespace startgit
@@ -1,62 +1,72 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
+#include <git2/patch.h>
 #include <git2wrap/commit.hpp>
 #include <git2wrap/diff.hpp>
 
+#include "cache.hpp"
+
 namespace startgit
 {
 
-struct line
+// Plain counts of a diff, they don't refer to any libgit2 object and can
+// be shared between threads and repository handles
+struct diff_stats
 {
-  friend class diff;
-  explicit line(const git_diff_line* lin)
-      : m_content(lin->content, lin->content_len)
-      , m_origin(lin->origin)
-  {
-  }
-
-  const std::string& get_content() const { return m_content; }
-  bool is_add() const { return m_origin == '+'; }
-  bool is_del() const { return m_origin == '-'; }
+  std::size_t files;
+  std::size_t insertions;
+  std::size_t deletions;
 
-private:
-  std::string m_content;
-  char m_origin;
+  std::size_t get_size() const { return sizeof(diff_stats); }
 };
 
-struct hunk
+// Points into the deltas owned by the diff, the patch is only generated
+// once the diff loads it
+class delta
 {
-  friend class diff;
-  explicit hunk(const git_diff_hunk* dlt)
-      : m_ptr(*dlt)
+public:
+  explicit delta(const git_diff_delta* dlt)
+      : m_ptr(dlt)
   {
   }
 
-  const auto* operator->() const { return &m_ptr; }
-  const auto& get_lines() const { return m_lines; }
+  const auto& get() const { return *m_ptr; }
+  const auto* operator->() const { return m_ptr; }
 
-private:
-  git_diff_hunk m_ptr;
-  std::vector<line> m_lines;
-};
-
-struct delta
-{
-  friend class diff;
-  explicit delta(const git_diff_delta* dlt)
-      : m_ptr(*dlt)
-  {
-  }
-  const auto* operator->() const { return &m_ptr; }
-  const auto& get_hunks() const { return m_hunks; }
+  bool is_loaded() const { return m_loaded; }
   auto get_adds() const { return m_adds; }
   auto get_dels() const { return m_dels; }
 
+  // bytes of the changed and context lines of the loaded patch
+  auto get_size() const { return m_size; }
+
+  // hands over hunks and lines of the loaded patch, nothing is copied
+  struct visitor
+  {
+    std::function<void(const git_diff_hunk&)> on_hunk;
+    std::function<void(const git_diff_line&)> on_line;
+  };
+
+  void visit(const visitor& vis) const;
+
 private:
-  git_diff_delta m_ptr;
-  std::vector<hunk> m_hunks;
+  friend class diff;
+
+  struct patch_free
+  {
+    void operator()(git_patch* ptr) const { git_patch_free(ptr); }
+  };
+
+  const git_diff_delta* m_ptr;
+  std::unique_ptr<git_patch, patch_free> m_patch;  // none for binary files
+  bool m_loaded = false;
+  std::size_t m_size = 0;
   uint32_t m_adds = 0;
   uint32_t m_dels = 0;
 };
@@ -64,34 +74,48 @@ private:
 class diff
 {
 public:
-  explicit diff(const git2wrap::commit& cmmt);
+  // blobs larger than max_size are not diffed, libgit2 treats them as binary
+  diff(const git2wrap::commit& cmmt, std::size_t max_size);
+
+  // totals over every file, libgit2 generates all of the patches for them
+  diff_stats get_stats() const;
 
-  std::string get_files_changed() const;
-  std::string get_insertions() const;
-  std::string get_deletions() const;
+  // one entry per file, listed without generating any patch
+  const std::vector<delta>& get_deltas() const { return m_deltas; }
 
-  const std::vector<delta>& get_deltas() const;
+  // generate the patch of a delta and count its lines, it is kept with
+  // the delta so the diffstat and the page are made from the same one
+  void load(std::size_t idx);
+
+  // lines of the loaded deltas
+  std::size_t get_insertions() const { return m_insertions; }
+  std::size_t get_deletions() const { return m_deletions; }
 
 private:
-  static int file_cb(
-      const git_diff_delta* delta, float progress, void* payload
-  );
+  git2wrap::diff m_diff;
 
-  static int hunk_cb(
-      const git_diff_delta* delta, const git_diff_hunk* hunk, void* payload
-  );
+  std::vector<delta> m_deltas;
+  std::size_t m_insertions = 0;
+  std::size_t m_deletions = 0;
+};
 
-  static int line_cb(
-      const git_diff_delta* delta,
-      const git_diff_hunk* hunk,
-      const git_diff_line* line,
-      void* payload
-  );
+// Process-wide, shared by every branch and repository of the run. Only
+// stats are kept, a diff stays with the thread and handle that made it.
+lru_cache<diff_stats>& diff_cache();
 
-  git2wrap::diff m_diff;
-  git2wrap::diff_stats m_stats;
+// Paths that differ between two trees, without computing any hunks
+struct tree_changes
+{
+  tree_changes(const git2wrap::tree& old_tree, const git2wrap::tree& new_tree);
 
-  mutable std::vector<delta> m_deltas;
+  std::unordered_set<std::string> added;
+  std::unordered_set<std::string> modified;
+  std::vector<std::string> deleted;
+
+private:
+  static int file_cb(
+      const git_diff_delta* delta, float progress, void* payload
+  );
 };
 
 }  // namespace startgit
@@ -1,19 +1,60 @@
 #include "document.hpp"
 
-#include <hemplate/html.hpp>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
 
-#include "arguments.hpp"
+#include <hemplate/html.hpp>
 
 namespace startgit
 {
 
 void document::render(std::ostream& ost, const content_t& content) const
+{
+  ost << shell(content());
+}
+
+void document::render(std::ostream& ost, const stream_t& content) const
+{
+  render_around(
+      ost,
+      [&](hemplate::element elem) { return shell(std::move(elem)); },
+      content
+  );
+}
+
+void render_around(
+    std::ostream& ost,
+    const std::function<hemplate::element(hemplate::element)>& shell,
+    const document::stream_t& content
+)
+{
+  static constexpr std::string_view marker = "<!-- content -->";
+
+  // the surrounding markup is tiny, split it where the content goes
+  std::ostringstream oss;
+  oss << shell(hemplate::element {std::string(marker)});
+
+  // titles and descriptions come before the content and may hold the
+  // marker themselves, the markup after it is fixed, so search backwards
+  const auto page = oss.str();
+  const auto pos = page.rfind(marker);
+
+  ost.write(page.data(), static_cast<std::streamsize>(pos));
+  content(ost);
+  ost << page.substr(pos + marker.size());
+}
+
+hemplate::element document::shell(hemplate::element content) const
 {
   using namespace hemplate::html;  // NOLINT
   using hemplate::html::div;
   using hemplate::html::link;
 
-  ost << element {
+  const auto& args = *m_args;
+
+  return element {
       doctype {},
       html {
           {{"lang", "en"}},
@@ -49,7 +90,7 @@ void document::render(std::ostream& ost, const content_t& content) const
                           {"class", "switch_label"},
                           {"for", "theme_switch"},
                       }},
-                      content(),
+                      std::move(content),
                   },
               },
               script {{{"src", args.resource_url + "/scripts/main.js"}}},
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <functional>
 #include <ostream>
 #include <string>
 
 #include <hemplate/element.hpp>
 
+#include "arguments.hpp"
 #include "branch.hpp"
 #include "repository.hpp"
 
@@ -13,31 +15,36 @@ namespace startgit
 
 class document
 {
+  const arguments_t* m_args;
   std::string m_title;
   std::string m_desc;
   std::string m_author;
   std::string m_relpath;
   bool m_has_feed;
 
-  static auto form_title(const repository& repo, const branch& branch)
+  static auto form_title(const repository& repo)
+  {
+    return std::format("{} - {}", repo.get_name(), repo.get_description());
+  }
+
+  static auto form_title(const repository& repo, std::string_view branch)
   {
     return std::format(
-        "{} ({}) - {}",
-        repo.get_name(),
-        branch.get_name(),
-        repo.get_description()
+        "{} ({}) - {}", repo.get_name(), branch, repo.get_description()
     );
   }
 
 public:
   document(
+      const arguments_t& args,
       std::string_view title,
       std::string_view desc,
       std::string_view author,
       std::string_view relpath = "./",
       bool has_feed = true
   )
-      : m_title(title)
+      : m_args(&args)
+      , m_title(title)
       , m_desc(desc)
       , m_author(author)
       , m_relpath(relpath)
@@ -45,6 +52,21 @@ public:
   {
   }
 
+  document(
+      const repository& repo,
+      std::string_view desc,
+      std::string_view relpath = "./",
+      bool has_feed = true
+  )
+      : m_args(&repo.get_args())
+      , m_title(form_title(repo))
+      , m_desc(desc)
+      , m_author(repo.get_owner())
+      , m_relpath(relpath)
+      , m_has_feed(has_feed)
+  {
+  }
+
   document(
       const repository& repo,
       const branch& branch,
@@ -52,7 +74,25 @@ public:
       std::string_view relpath = "./",
       bool has_feed = true
   )
-      : m_title(form_title(repo, branch))
+      : m_args(&repo.get_args())
+      , m_title(form_title(repo, branch.get_name()))
+      , m_desc(desc)
+      , m_author(repo.get_owner())
+      , m_relpath(relpath)
+      , m_has_feed(has_feed)
+  {
+  }
+
+  // a branch that was not built, only its ref is known
+  document(
+      const repository& repo,
+      const repository::branch_ref& ref,
+      std::string_view desc,
+      std::string_view relpath = "./",
+      bool has_feed = true
+  )
+      : m_args(&repo.get_args())
+      , m_title(form_title(repo, ref.name))
       , m_desc(desc)
       , m_author(repo.get_owner())
       , m_relpath(relpath)
@@ -62,6 +102,21 @@ public:
 
   using content_t = std::function<hemplate::element()>;
   void render(std::ostream& ost, const content_t& content) const;
+
+  // content is written straight into the page instead of being built first
+  using stream_t = std::function<void(std::ostream&)>;
+  void render(std::ostream& ost, const stream_t& content) const;
+
+private:
+  hemplate::element shell(hemplate::element content) const;
 };
 
+// Write the markup made by shell, with content streamed in place of the
+// element shell is given, e.g. the entries of a feed
+void render_around(
+    std::ostream& ost,
+    const std::function<hemplate::element(hemplate::element)>& shell,
+    const document::stream_t& content
+);
+
 }  // namespace startgit
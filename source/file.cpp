@@ -1,36 +1,161 @@
 #include <algorithm>
+#include <array>
 #include <span>
 
 #include "file.hpp"
 
-#include <git2wrap/repository.hpp>
-
 #include "utils.hpp"
 
 namespace startgit
 {
 
-file::file(const git2wrap::tree_entry& entry, std::filesystem::path path)
-    : m_filemode(filemode(entry.get_filemode()))
+file::file(
+    const git2wrap::repository& repo,
+    const git2wrap::tree_entry& entry,
+    std::filesystem::path path
+)
+    : m_repo(&repo)
+    , m_id(entry.get_id())
+    , m_filemode(entry.get_filemode())
     , m_path(std::move(path))
-    , m_blob(git2wrap::repository(entry.get_owner()).blob_lookup(entry.get_id())
-      )
 {
 }
 
+const git2wrap::blob& file::get_blob() const
+{
+  if (!m_blob.has_value()) {
+    m_blob.emplace(m_repo->blob_lookup(m_id));
+  }
+
+  return *m_blob;
+}
+
+void file::read_header(const git2wrap::repository& repo) const
+{
+  git_odb* odb = nullptr;
+  std::size_t size = 0;
+  git_object_t type = GIT_OBJECT_INVALID;
+
+  if (git_repository_odb(&odb, repo.get()) == 0) {
+    const int err = git_odb_read_header(&size, &type, odb, m_id.ptr());
+    git_odb_free(odb);
+
+    if (err == 0) {
+      m_size = static_cast<git2wrap::object_size_t>(size);
+      return;
+    }
+  }
+
+  // let the regular lookup report whatever went wrong
+  m_size = repo.blob_lookup(m_id).get_rawsize();
+}
+
+std::optional<bool> file::binary_attribute(
+    const git2wrap::repository& repo
+) const
+{
+  const auto path = m_path.string();
+  const auto lookup = [&](const char* name)
+  {
+    const char* value = nullptr;
+    const auto flags = GIT_ATTR_CHECK_FILE_THEN_INDEX  // NOLINT
+        | GIT_ATTR_CHECK_INCLUDE_HEAD;
+    if (git_attr_get(&value, repo.get(), flags, path.c_str(), name) != 0) {
+      return GIT_ATTR_VALUE_UNSPECIFIED;
+    }
+    return git_attr_value(value);
+  };
+
+  // "binary" unsets both of these, "text" alone marks a text file
+  const auto text = lookup("text");
+  if (text == GIT_ATTR_VALUE_TRUE) {
+    return false;
+  }
+
+  if (text == GIT_ATTR_VALUE_FALSE || lookup("diff") == GIT_ATTR_VALUE_FALSE) {
+    return true;
+  }
+
+  return std::nullopt;
+}
+
+std::optional<bool> file::sniff_binary(const git2wrap::repository& repo) const
+{
+  git_odb* odb = nullptr;
+  if (git_repository_odb(&odb, repo.get()) != 0) {
+    return std::nullopt;
+  }
+
+  // only loose objects can be streamed, packed ones are read whole,
+  // for those only the attributes can tell without inflating them
+  git_odb_stream* stream = nullptr;
+  std::size_t size = 0;
+  git_object_t type = GIT_OBJECT_INVALID;
+  if (git_odb_open_rstream(&stream, &size, &type, odb, m_id.ptr()) != 0) {
+    git_odb_free(odb);
+    return binary_attribute(repo);
+  }
+
+  // same test as git, a NUL byte early in the content marks it binary
+  static constexpr std::size_t sniff_size = 8000;
+  std::array<char, sniff_size> buffer = {};
+  std::size_t total = 0;
+  int res = 0;
+
+  while (total < buffer.size()) {
+    res = git_odb_stream_read(
+        stream,
+        buffer.data() + total,  // NOLINT
+        buffer.size() - total
+    );
+    if (res <= 0) {
+      break;
+    }
+    total += static_cast<std::size_t>(res);
+  }
+
+  git_odb_stream_free(stream);
+  git_odb_free(odb);
+
+  if (res < 0) {
+    return std::nullopt;
+  }
+
+  const auto head = std::span<const char>(buffer.data(), total);
+  return std::ranges::find(head, '\0') != head.end();
+}
+
+void file::load(const git2wrap::repository& repo) const
+{
+  m_blob.emplace(repo.blob_lookup(m_id));
+}
+
+std::string file::get_filemode() const
+{
+  return filemode(m_filemode);
+}
+
 bool file::is_binary() const
 {
-  return m_blob.is_binary();
+  return get_blob().is_binary();
 }
 
 const char* file::get_content() const
 {
-  return static_cast<const char*>(m_blob.get_rawcontent());
+  return static_cast<const char*>(get_blob().get_rawcontent());
 }
 
 git2wrap::object_size_t file::get_size() const
 {
-  return m_blob.get_rawsize();
+  if (!m_size.has_value()) {
+    if (m_blob.has_value()) {
+      m_size = m_blob->get_rawsize();
+    } else {
+      read_header(*m_repo);
+    }
+  }
+
+  return *m_size;
 }
 
 int file::get_lines() const
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <filesystem>
+#include <optional>
 #include <string>
 
 #include <git2wrap/blob.hpp>
+#include <git2wrap/repository.hpp>
 #include <git2wrap/tree.hpp>
 
 namespace startgit
@@ -12,21 +14,45 @@ namespace startgit
 class file
 {
 public:
-  file(const git2wrap::tree_entry& entry, std::filesystem::path path);
+  file(
+      const git2wrap::repository& repo,
+      const git2wrap::tree_entry& entry,
+      std::filesystem::path path
+  );
 
-  std::string get_filemode() const { return m_filemode; }
+  std::string get_filemode() const;
   std::filesystem::path get_path() const { return m_path; }
+  const git2wrap::oid& get_id() const { return m_id; }
 
   bool is_binary() const;
   const char* get_content() const;
   git2wrap::object_size_t get_size() const;
   int get_lines() const;
 
+  // read only the size from the object header, the blob stays packed
+  void read_header(const git2wrap::repository& repo) const;
+
+  // look only at the start of the blob, empty if it can't be streamed
+  std::optional<bool> sniff_binary(const git2wrap::repository& repo) const;
+
+  // load the contents through a specific handle, e.g. of a worker thread
+  void load(const git2wrap::repository& repo) const;
+
+  // drop the blob contents, they are loaded again on the next access
+  void release() const { m_blob.reset(); }
+
 private:
-  std::string m_filemode;
+  const git2wrap::blob& get_blob() const;
+  std::optional<bool> binary_attribute(const git2wrap::repository& repo) const;
+
+  const git2wrap::repository* m_repo;
+
+  git2wrap::oid m_id;
+  git2wrap::filemode_t m_filemode;
   std::filesystem::path m_path;
-  git2wrap::blob m_blob;
 
+  mutable std::optional<git2wrap::blob> m_blob;
+  mutable std::optional<git2wrap::object_size_t> m_size;
   mutable int m_lines = -1;
 };
 
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+
+#include "history.hpp"
+
+#include "commit_graph.hpp"
+
+namespace startgit
+{
+
+history::history(
+    const git2wrap::repository& repo, const std::vector<git2wrap::oid>& tips
+)
+    : m_repo(&repo)
+    , m_words((tips.size() + bits - 1) / bits)
+{
+  const commit_graph graph(repo);
+
+  std::unordered_map<std::string, std::size_t> index;
+  std::vector<std::vector<std::size_t>> parents;
+  std::vector<std::size_t> stack;
+
+  const auto add = [&](const git2wrap::oid& oid)
+  {
+    const auto [itr, inserted] =
+        index.emplace(oid.get_hex_string(40), m_nodes.size());  // NOLINT
+    if (inserted) {
+      m_nodes.push_back({oid, 0});
+      parents.emplace_back();
+      stack.push_back(itr->second);
+    }
+    return itr->second;
+  };
+
+  for (const auto& tip : tips) {
+    m_tips.push_back(add(tip));
+  }
+
+  std::vector<std::uint32_t> gparents;
+  while (!stack.empty()) {
+    const auto idx = stack.back();
+    stack.pop_back();
+
+    const auto oid = m_nodes[idx].id;
+    const auto pos = graph.find(oid);
+    if (pos && graph.get_parents(*pos, gparents)) {
+      m_nodes[idx].time = graph.get_time(*pos);
+
+      for (const auto parent : gparents) {
+        const auto pidx = add(graph.get_id(parent));
+        parents[idx].push_back(pidx);
+      }
+      continue;
+    }
+
+    // not in the graph yet, no graph at all, or a damaged one
+    const commit cmmt(m_repo->commit_lookup(oid));
+    m_nodes[idx].time = cmmt.get().get_time();
+
+    for (std::size_t j = 0; j < cmmt.get_parentcount(); j++) {
+      const auto pidx = add(cmmt.get().get_parent(j).get_id());
+      parents[idx].push_back(pidx);
+    }
+  }
+
+  // newest first, the same order a revwalk would give
+  std::vector<std::size_t> order(m_nodes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(
+      order.begin(),
+      order.end(),
+      [&](auto lhs, auto rhs) { return m_nodes[lhs].time > m_nodes[rhs].time; }
+  );
+
+  std::vector<std::size_t> remap(m_nodes.size());
+  for (std::size_t i = 0; i < order.size(); i++) {
+    remap[order[i]] = i;
+  }
+
+  {
+    std::vector<node> nodes;
+    std::vector<std::vector<std::size_t>> sorted(m_nodes.size());
+
+    nodes.reserve(m_nodes.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+      nodes.push_back(std::move(m_nodes[order[i]]));
+      for (const auto parent : parents[order[i]]) {
+        sorted[i].push_back(remap[parent]);
+      }
+    }
+
+    m_nodes = std::move(nodes);
+    parents = std::move(sorted);
+  }
+
+  for (auto& tip : m_tips) {
+    tip = remap[tip];
+    m_heads.push_back(get_commit(tip));
+  }
+
+  m_reach.resize(m_nodes.size() * m_words);
+
+  for (std::size_t i = 0; i < m_tips.size(); i++) {
+    const auto idx = m_tips[i];
+    m_reach[(idx * m_words) + (i / bits)] |= std::uint64_t {1} << (i % bits);
+  }
+
+  // number of children for each commit
+  std::vector<std::size_t> children(m_nodes.size(), 0);
+  for (const auto& list : parents) {
+    for (const auto parent : list) {
+      children[parent]++;
+    }
+  }
+
+  // push reachability down to the parents in topological order,
+  // so every commit is visited once regardless of the number of tips
+  std::vector<std::size_t> ready;
+  for (std::size_t i = 0; i < m_nodes.size(); i++) {
+    if (children[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+
+  while (!ready.empty()) {
+    const auto crnt = ready.back();
+    ready.pop_back();
+
+    for (const auto parent : parents[crnt]) {
+      for (std::size_t w = 0; w < m_words; w++) {
+        m_reach[(parent * m_words) + w] |= m_reach[(crnt * m_words) + w];
+      }
+
+      if (--children[parent] == 0) {
+        ready.push_back(parent);
+      }
+    }
+  }
+}
+
+std::size_t history::count(std::size_t tip) const
+{
+  std::size_t res = 0;
+  for (std::size_t idx = 0; idx < size(); idx++) {
+    res += reaches(idx, tip) ? 1 : 0;
+  }
+  return res;
+}
+
+commit history::get_commit(std::size_t idx) const
+{
+  return commit(m_repo->commit_lookup(m_nodes[idx].id));
+}
+
+}  // namespace startgit
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include <git2wrap/oid.hpp>
+#include <git2wrap/repository.hpp>
+
+#include "commit.hpp"
+
+namespace startgit
+{
+
+// Every commit reachable from any of the tips, walked once and stored once.
+// Each commit carries a bitset with one bit per tip that reaches it.
+// The walk goes through the commit-graph where there is one, and only ids
+// are kept: iterating looks each commit up as it is reached and hands it
+// over by value, so rendering holds one commit at a time.
+class history
+{
+public:
+  class view
+  {
+  public:
+    class iterator
+    {
+    public:
+      using iterator_concept = std::forward_iterator_tag;
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = commit;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = commit;
+
+      iterator() = default;
+      iterator(const history* hist, std::size_t tip, std::size_t idx)
+          : m_hist(hist)
+          , m_tip(tip)
+          , m_idx(idx)
+      {
+        skip();
+      }
+
+      reference operator*() const { return m_hist->get_commit(m_idx); }
+
+      iterator& operator++()
+      {
+        m_idx++;
+        skip();
+        return *this;
+      }
+
+      iterator operator++(int)
+      {
+        auto tmp = *this;
+        ++*this;
+        return tmp;
+      }
+
+      friend bool operator==(const iterator& lhs, const iterator& rhs)
+      {
+        return lhs.m_idx == rhs.m_idx;
+      }
+
+    private:
+      void skip()
+      {
+        while (m_idx < m_hist->size() && !m_hist->reaches(m_idx, m_tip)) {
+          m_idx++;
+        }
+      }
+
+      const history* m_hist = nullptr;
+      std::size_t m_tip = 0;
+      std::size_t m_idx = 0;
+    };
+
+    view() = default;
+    view(const history* hist, std::size_t tip)
+        : m_hist(hist)
+        , m_tip(tip)
+    {
+    }
+
+    iterator begin() const { return {m_hist, m_tip, 0}; }
+    iterator end() const { return {m_hist, m_tip, m_hist->size()}; }
+
+    const commit& get_tip() const { return m_hist->get_tip(m_tip); }
+    std::size_t size() const { return m_hist->count(m_tip); }
+
+  private:
+    const history* m_hist = nullptr;
+    std::size_t m_tip = 0;
+  };
+
+  history(
+      const git2wrap::repository& repo, const std::vector<git2wrap::oid>& tips
+  );
+
+  std::size_t size() const { return m_nodes.size(); }
+
+  bool reaches(std::size_t idx, std::size_t tip) const
+  {
+    const auto word = m_reach[(idx * m_words) + (tip / bits)];
+    return ((word >> (tip % bits)) & 1U) != 0;
+  }
+
+  // commits reachable from a tip, counted from the bitsets alone
+  std::size_t count(std::size_t tip) const;
+
+  const commit& get_tip(std::size_t tip) const { return m_heads[tip]; }
+
+  view get_view(std::size_t tip) const { return {this, tip}; }
+
+private:
+  static constexpr std::size_t bits = 64;
+
+  struct node
+  {
+    git2wrap::oid id;
+    std::int64_t time = 0;
+  };
+
+  commit get_commit(std::size_t idx) const;
+
+  const git2wrap::repository* m_repo;
+
+  std::vector<node> m_nodes;
+  std::vector<std::size_t> m_tips;
+  std::vector<commit> m_heads;
+
+  std::size_t m_words = 0;
+  std::vector<std::uint64_t> m_reach;
+};
+
+}  // namespace startgit
@@ -2,10 +2,12 @@
 #include <format>
 #include <functional>
 #include <string>
+#include <string_view>
 
 #include <md4c-html.h>
 
 #include "arguments.hpp"
+#include "utils.hpp"
 
 constexpr bool isdigit(char chr)
 {
@@ -30,11 +32,6 @@ constexpr bool isalnum(char chr)
 class md_html
 {
 public:
-  static bool need_html_esc(char chr)
-  {
-    return escape_map[static_cast<size_t>(chr)] & esc_flag::html;  // NOLINT
-  }
-
   static bool need_url_esc(char chr)
   {
     return escape_map[static_cast<size_t>(chr)] & esc_flag::url;  // NOLINT
@@ -63,29 +60,27 @@ public:
 
   void (*process_output)(const MD_CHAR*, MD_SIZE, void*);
   void* userdata;
+  const startgit::arguments_t* args;
   unsigned flags;
   int image_nesting_level;
 
+  // reused by every escaped chunk of the document
+  std::string escaped;
+
 private:
   enum esc_flag : unsigned char
   {
-    html = 0x1U,
-    url = 0x2U
+    url = 0x1U
   };
 
   static constexpr const std::array<unsigned char, 256> escape_map = []()
   {
     std::array<unsigned char, 256> res = {};
     const std::string url_esc = "~-_.+!*(),%#@?=;:/,+$";
-    const std::string html_esc = "\"&<>";
 
     for (size_t i = 0; i < res.size(); ++i) {
       const auto chr = static_cast<char>(i);
 
-      if (html_esc.find(chr) != std::string::npos) {
-        res[i] |= esc_flag::html;  // NOLINT
-      }
-
       if (!isalnum(chr) && url_esc.find(chr) == std::string::npos) {
         res[i] |= esc_flag::url;  // NOLINT
       }
@@ -110,61 +105,43 @@ void md_html::render_verbatim(const std::string& text)  // NOLINT
 
 void md_html::render_html_escaped(const MD_CHAR* data, MD_SIZE size)
 {
-  MD_OFFSET beg = 0;
-  MD_OFFSET off = 0;
+  escaped.clear();
 
-  while (true) {
-    /* Optimization: Use some loop unrolling. */
-    while (off + 3 < size && !md_html::need_html_esc(data[off + 0])  // NOLINT
-           && !md_html::need_html_esc(data[off + 1])  // NOLINT
-           && !md_html::need_html_esc(data[off + 2])  // NOLINT
-           && !md_html::need_html_esc(data[off + 3]))  // NOLINT
-    {
-      off += 4;
-    }
+  std::string_view str(data, size);
+  while (!str.empty()) {
+    const auto off = startgit::find_escape(str);
+    escaped.append(str.data(), off);
 
-    while (off < size && !md_html::need_html_esc(data[off])) {  // NOLINT
-      off++;
-    }
-
-    if (off > beg) {
-      render_verbatim(data + beg, off - beg);  // NOLINT
+    if (off == str.size()) {
+      break;
     }
 
-    if (off < size) {
-      switch (data[off]) {  // NOLINT
-        case '&':
-          render_verbatim("&amp;");
-          break;
-        case '<':
-          render_verbatim("&lt;");
-          break;
-        case '>':
-          render_verbatim("&gt;");
-          break;
-        case '"':
-          render_verbatim("&quot;");
-          break;
-      }
-      off++;
+    // markdown keeps its quotes and line breaks as they are
+    const char chr = str[off];
+    if (chr == '\'' || chr == '\n') {
+      escaped += chr;
     } else {
-      break;
+      escaped += startgit::escape_entity(chr);
     }
-    beg = off;
+    str.remove_prefix(off + 1);
   }
+
+  render_verbatim(escaped);
 }
 
-std::string translate_url(const MD_CHAR* data, MD_SIZE size)
+std::string translate_url(
+    const startgit::arguments_t& args, const MD_CHAR* data, MD_SIZE size
+)
 {
   auto url = std::string(data, size);
 
   if (url.rfind("http", 0) != std::string::npos
       || url.rfind("www", 0) != std::string::npos)
   {
-    const std::string github = "github.com/" + startgit::args.github;
+    const std::string github = "github.com/" + args.github;
     const std::size_t gpos = url.find(github);
     if (gpos != std::string::npos) {
-      url = startgit::args.base_url + url.substr(gpos + github.size());
+      url = args.base_url + url.substr(gpos + github.size());
 
       static const std::string blob = "/blob";
       const std::size_t bpos = url.find(blob);
@@ -173,8 +150,8 @@ std::string translate_url(const MD_CHAR* data, MD_SIZE size)
 
         const std::size_t rslash = url.rfind('/');
 
-        auto itr = startgit::args.special.find(url.substr(rslash + 1));
-        if (itr != startgit::args.special.end()) {
+        auto itr = args.special.find(url.substr(rslash + 1));
+        if (itr != args.special.end()) {
           auto cpy = *itr;
           url = std::format(
               "{}/{}.html",
@@ -191,8 +168,8 @@ std::string translate_url(const MD_CHAR* data, MD_SIZE size)
       }
     }
   } else {
-    auto itr = startgit::args.special.find(url);
-    if (itr != startgit::args.special.end()) {
+    auto itr = args.special.find(url);
+    if (itr != args.special.end()) {
       auto cpy = *itr;
       url = std::format("./{}.html", cpy.replace_extension().string());
     } else {
@@ -209,7 +186,7 @@ void md_html::render_url_escaped(const MD_CHAR* data, MD_SIZE size)
   MD_OFFSET beg = 0;
   MD_OFFSET off = 0;
 
-  const auto urll = translate_url(data, size);
+  const auto urll = translate_url(*args, data, size);
   size = static_cast<unsigned>(urll.size());
   data = urll.data();
 
@@ -739,6 +716,7 @@ int md_html(
     MD_SIZE input_size,
     void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
     void* userdata,
+    const arguments_t& args,
     unsigned parser_flags,
     unsigned renderer_flags
 )
@@ -746,6 +724,7 @@ int md_html(
   class md_html render = {
       .process_output = process_output,
       .userdata = userdata,
+      .args = &args,
       .flags = renderer_flags,
       .image_nesting_level = 0
   };
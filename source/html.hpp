@@ -2,6 +2,8 @@
 
 #include <md4c.h>
 
+#include "arguments.hpp"
+
 namespace startgit
 {
 
@@ -10,6 +12,7 @@ int md_html(
     MD_SIZE input_size,
     void (*process_output)(const MD_CHAR*, MD_SIZE, void*),
     void* userdata,
+    const arguments_t& args,
     unsigned parser_flags,
     unsigned renderer_flags
 );
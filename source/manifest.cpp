@@ -0,0 +1,49 @@
+#include <fstream>
+#include <sstream>
+
+#include "manifest.hpp"
+
+namespace startgit
+{
+
+manifest::manifest(std::filesystem::path path)
+    : m_path(std::move(path))
+{
+  std::ifstream ifs(m_path);
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    const auto pos = line.find(' ');
+    if (pos == std::string::npos) {
+      continue;
+    }
+
+    const auto key = line.substr(0, pos);
+    auto value = line.substr(pos + 1);
+
+    if (key == "tip") {
+      m_tip = std::move(value);
+    } else if (key == "tree") {
+      m_tree = std::move(value);
+    } else if (key == "ref") {
+      m_refs += value + '\n';
+    }
+  }
+}
+
+void manifest::write() const
+{
+  std::ofstream ofs(m_path);
+
+  ofs << "tip " << m_tip << '\n';
+  ofs << "tree " << m_tree << '\n';
+
+  std::istringstream refs(m_refs);
+
+  std::string line;
+  while (std::getline(refs, line)) {
+    ofs << "ref " << line << '\n';
+  }
+}
+
+}  // namespace startgit
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace startgit
+{
+
+// What was rendered for a branch by the previous run, kept in the output
+// directory so reruns only redo the pages whose inputs have changed.
+class manifest
+{
+public:
+  explicit manifest(std::filesystem::path path);
+
+  const std::string& get_tip() const { return m_tip; }
+  const std::string& get_tree() const { return m_tree; }
+  const std::string& get_refs() const { return m_refs; }
+
+  void set_tip(std::string tip) { m_tip = std::move(tip); }
+  void set_tree(std::string tree) { m_tree = std::move(tree); }
+  void set_refs(std::string refs) { m_refs = std::move(refs); }
+
+  void write() const;
+
+private:
+  std::filesystem::path m_path;
+
+  std::string m_tip;
+  std::string m_tree;
+  std::string m_refs;
+};
+
+}  // namespace startgit
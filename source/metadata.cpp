@@ -0,0 +1,207 @@
+#include <cstring>
+#include <fstream>
+
+#include "metadata.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace startgit
+{
+
+namespace
+{
+
+constexpr std::array<char, 8> magic = {'s', 'g', 'm', 'e', 't', 'a', '0', '1'};
+
+constexpr std::uint8_t flag_binary = 0x1U;
+constexpr std::uint8_t flag_counted = 0x2U;
+
+}  // namespace
+
+std::size_t metadata::key_hash::operator()(const key_t& key) const
+{
+  // object ids are already uniformly distributed
+  std::size_t res = 0;
+  std::memcpy(&res, key.data(), sizeof(res));
+  return res;
+}
+
+metadata::metadata(std::filesystem::path path, std::uint64_t diff_limit)
+    : m_path(std::move(path))
+    , m_diff_limit(diff_limit)
+{
+  const int fdes = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT
+  if (fdes == -1) {
+    return;
+  }
+
+  struct stat stt = {};
+  if (::fstat(fdes, &stt) == 0 && stt.st_size > 0) {
+    m_map_size = static_cast<std::size_t>(stt.st_size);
+    m_map = ::mmap(nullptr, m_map_size, PROT_READ, MAP_PRIVATE, fdes, 0);
+    if (m_map == MAP_FAILED) {  // NOLINT
+      m_map = nullptr;
+    }
+  }
+  ::close(fdes);
+
+  if (m_map == nullptr || m_map_size < sizeof(header)) {
+    return;
+  }
+
+  header hdr = {};
+  std::memcpy(&hdr, m_map, sizeof(hdr));
+  if (hdr.magic != magic || hdr.diff_limit != m_diff_limit) {
+    return;
+  }
+
+  // a record cut short by an interrupted run is simply ignored
+  m_valid = true;
+  m_mapped = reinterpret_cast<const record*>(  // NOLINT
+      static_cast<const char*>(m_map) + sizeof(header)  // NOLINT
+  );
+  m_mapped_count = (m_map_size - sizeof(header)) / sizeof(record);
+}
+
+metadata::~metadata()
+{
+  if (m_map != nullptr) {
+    ::munmap(m_map, m_map_size);
+  }
+}
+
+metadata::key_t metadata::to_key(const git2wrap::oid& oid)
+{
+  key_t key = {};
+  std::memcpy(key.data(), oid.ptr()->id, key.size());
+  return key;
+}
+
+void metadata::index() const
+{
+  if (m_indexed) {
+    return;
+  }
+
+  // a run where nothing changed never looks anything up
+  m_index.reserve(m_mapped_count);
+  for (std::size_t i = 0; i < m_mapped_count; i++) {
+    m_index.insert_or_assign(m_mapped[i].key, i);  // NOLINT
+  }
+  m_indexed = true;
+}
+
+const metadata::record* metadata::find(
+    const git2wrap::oid& oid, kind_t kind
+) const
+{
+  index();
+
+  const auto itr = m_index.find(to_key(oid));
+  if (itr == m_index.end()) {
+    return nullptr;
+  }
+
+  const auto idx = itr->second;
+  const auto* rec = idx < m_mapped_count
+      ? &m_mapped[idx]  // NOLINT
+      : &m_pending[idx - m_mapped_count];
+
+  return rec->kind == kind ? rec : nullptr;
+}
+
+void metadata::put(const record& rec)
+{
+  index();
+  m_index.insert_or_assign(rec.key, m_mapped_count + m_pending.size());
+  m_pending.push_back(rec);
+}
+
+std::optional<metadata::commit_stats> metadata::get_commit(
+    const git2wrap::oid& oid
+) const
+{
+  const auto* rec = find(oid, kind_t::commit);
+  if (rec == nullptr) {
+    return {};
+  }
+
+  return commit_stats {rec->values[0], rec->values[1], rec->values[2]};
+}
+
+std::optional<metadata::blob_info> metadata::get_blob(
+    const git2wrap::oid& oid
+) const
+{
+  const auto* rec = find(oid, kind_t::blob);
+  if (rec == nullptr) {
+    return {};
+  }
+
+  return blob_info {
+      rec->values[0],
+      rec->values[1],
+      (rec->flags & flag_binary) != 0,
+      (rec->flags & flag_counted) != 0,
+  };
+}
+
+void metadata::put_commit(const git2wrap::oid& oid, const commit_stats& stats)
+{
+  record rec = {};
+  rec.key = to_key(oid);
+  rec.kind = kind_t::commit;
+  rec.values = {stats.files, stats.insertions, stats.deletions};
+  put(rec);
+}
+
+void metadata::put_blob(const git2wrap::oid& oid, const blob_info& info)
+{
+  record rec = {};
+  rec.key = to_key(oid);
+  rec.kind = kind_t::blob;
+  rec.flags = static_cast<std::uint8_t>(
+      (info.binary ? flag_binary : 0U) | (info.counted ? flag_counted : 0U)
+  );
+  rec.values = {info.size, info.lines, 0};
+  put(rec);
+}
+
+void metadata::write()
+{
+  if (m_written == m_pending.size()) {
+    return;
+  }
+
+  // start over if the old file was missing, damaged or made differently
+  const auto mode = m_valid ? std::ios::binary | std::ios::app
+                            : std::ios::binary | std::ios::trunc;
+  std::ofstream ofs(m_path, mode);
+
+  if (!m_valid) {
+    const header hdr = {magic, m_diff_limit};
+    ofs.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));  // NOLINT
+    m_valid = true;
+  } else if (m_written == 0) {
+    // drop a partial record left at the end by an interrupted run
+    const auto size = sizeof(header) + m_mapped_count * sizeof(record);
+    if (size != m_map_size) {
+      ofs.close();
+      std::filesystem::resize_file(m_path, size);
+      ofs.open(m_path, mode);
+    }
+  }
+
+  const auto count = m_pending.size() - m_written;
+  ofs.write(
+      reinterpret_cast<const char*>(&m_pending[m_written]),  // NOLINT
+      static_cast<std::streamsize>(count * sizeof(record))
+  );
+
+  m_written = m_pending.size();
+}
+
+}  // namespace startgit
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include <git2wrap/oid.hpp>
+
+namespace startgit
+{
+
+// Facts about objects that never change for a given id, kept next to the
+// output of a repository so later runs can skip diffing and inflating.
+// The file is a header followed by fixed size records, it is mapped read
+// only and new records are appended to the end. Not thread safe, it is
+// read by the task queuing the pages of its repository, and only then
+// used by the task writing its indexes.
+class metadata
+{
+public:
+  struct commit_stats
+  {
+    std::uint64_t files;
+    std::uint64_t insertions;
+    std::uint64_t deletions;
+  };
+
+  struct blob_info
+  {
+    std::uint64_t size;
+    std::uint64_t lines;
+    bool binary;
+    bool counted;  // lines are only known for blobs that were loaded
+  };
+
+  // records made with a different diff size limit are not reused
+  metadata(std::filesystem::path path, std::uint64_t diff_limit);
+
+  metadata(const metadata&) = delete;
+  metadata& operator=(const metadata&) = delete;
+  metadata(metadata&&) = delete;
+  metadata& operator=(metadata&&) = delete;
+  ~metadata();
+
+  std::optional<commit_stats> get_commit(const git2wrap::oid& oid) const;
+  std::optional<blob_info> get_blob(const git2wrap::oid& oid) const;
+
+  void put_commit(const git2wrap::oid& oid, const commit_stats& stats);
+  void put_blob(const git2wrap::oid& oid, const blob_info& info);
+
+  // append the records added since the file was mapped
+  void write();
+
+private:
+  static constexpr std::size_t oid_size = sizeof(git_oid::id);
+  using key_t = std::array<unsigned char, oid_size>;
+
+  struct key_hash
+  {
+    std::size_t operator()(const key_t& key) const;
+  };
+
+  enum class kind_t : std::uint8_t
+  {
+    commit = 1,
+    blob = 2,
+  };
+
+  struct header
+  {
+    std::array<char, 8> magic;
+    std::uint64_t diff_limit;
+  };
+
+  // written to disk as is, so no byte of it is left to padding
+  struct record
+  {
+    key_t key;
+    kind_t kind;
+    std::uint8_t flags;
+    std::array<std::uint8_t, 2> reserved;  // always zero
+    std::array<std::uint64_t, 3> values;
+  };
+
+  static_assert(sizeof(header) == 16);
+  static_assert(sizeof(record) == oid_size + 4 + (3 * 8));
+
+  static key_t to_key(const git2wrap::oid& oid);
+
+  void index() const;
+  const record* find(const git2wrap::oid& oid, kind_t kind) const;
+  void put(const record& rec);
+
+  std::filesystem::path m_path;
+  std::uint64_t m_diff_limit;
+
+  const record* m_mapped = nullptr;
+  std::size_t m_mapped_count = 0;
+  void* m_map = nullptr;
+  std::size_t m_map_size = 0;
+  bool m_valid = false;
+
+  std::vector<record> m_pending;
+  std::size_t m_written = 0;
+  mutable bool m_indexed = false;
+  mutable std::unordered_map<key_t, std::size_t, key_hash> m_index;
+};
+
+}  // namespace startgit
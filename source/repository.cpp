@@ -1,12 +1,23 @@
+#include <format>
 #include <fstream>
+#include <iostream>
 
 #include "repository.hpp"
 
+#include <git2/graph.h>
+#include <git2wrap/error.hpp>
+#include <git2wrap/revwalk.hpp>
+
+#include "commit_graph.hpp"
+
 namespace startgit
 {
 
-repository::repository(const std::filesystem::path& path)
-    : m_path(path)
+repository::repository(
+    const std::filesystem::path& path, const arguments_t& args
+)
+    : m_args(&args)
+    , m_path(path)
     , m_repo(git2wrap::repository::open(
           path.c_str(), git2wrap::repository::flags_open::no_search, nullptr
       ))
@@ -15,23 +26,148 @@ repository::repository(const std::filesystem::path& path)
     , m_owner(read_file(path, "owner"))
     , m_description(read_file(path, "description"))
 {
-  // Get branches
+  // List branches, their history is only walked once asked for
   for (auto it = m_repo.branch_begin(git2wrap::branch::flags_list::local);
        it != m_repo.branch_end();
        ++it)
   {
-    m_branches.emplace_back(it->dup(), *this);
+    const auto tip = m_repo.revparse(it->get_name().c_str()).get_id();
+    m_branch_refs.push_back({it->dup(), it->get_name(), tip});
   }
 
-  // Get tags
-  auto callback = +[](const char*, git_oid* objid, void* payload_p)
+  // List tags, without looking up the tag objects
+  auto callback = +[](const char* name, git_oid* objid, void* payload_p)
   {
-    auto& repo = *reinterpret_cast<repository*>(payload_p);  // NOLINT
-    repo.m_tags.emplace_back(repo.m_repo.tag_lookup(git2wrap::oid(objid)));
+    static constexpr std::string_view prefix = "refs/tags/";
+
+    auto& refs = *reinterpret_cast<std::vector<tag_ref>*>(payload_p);  // NOLINT
+    std::string_view view = name;
+    if (view.starts_with(prefix)) {
+      view.remove_prefix(prefix.size());
+    }
+
+    refs.push_back({std::string(view), git2wrap::oid(objid)});
     return 0;
   };
 
-  m_repo.tag_foreach(callback, this);
+  m_repo.tag_foreach(callback, &m_tag_refs);
+
+  if (args.commit_graph && !commit_graph::write(m_repo)) {
+    std::cerr << std::format(
+        "Warning: {}: could not write the commit-graph\n", path.string()
+    );
+  }
+}
+
+const std::vector<branch>& repository::get_branches(
+    const std::unordered_set<std::string>& names
+) const
+{
+  std::call_once(
+      m_branches_flag,
+      [&]()
+      {
+        std::vector<const branch_ref*> refs;
+        std::vector<git2wrap::oid> tips;
+        for (const auto& ref : m_branch_refs) {
+          if (names.contains(ref.name)) {
+            refs.push_back(&ref);
+            tips.push_back(ref.tip);
+          }
+        }
+
+        // Walk the history of all selected branches at once
+        m_history = std::make_unique<history>(m_repo, tips);
+
+        m_branches.reserve(refs.size());
+        for (std::size_t i = 0; i < refs.size(); i++) {
+          m_branches.emplace_back(
+              refs[i]->ref.dup(),
+              m_history->get_view(i),
+              m_repo,
+              m_args->special
+          );
+        }
+      }
+  );
+
+  return m_branches;
+}
+
+const std::vector<tag>& repository::get_tags() const
+{
+  std::call_once(
+      m_tags_flag,
+      [&]()
+      {
+        m_tags.reserve(m_tag_refs.size());
+        for (const auto& ref : m_tag_refs) {
+          m_tags.emplace_back(m_repo.tag_lookup(ref.id));
+        }
+      }
+  );
+
+  return m_tags;
+}
+
+std::optional<std::size_t> repository::count_commits(
+    const git2wrap::oid& tip, const std::string& since
+) const
+{
+  std::optional<git2wrap::oid> hide;
+  if (!since.empty()) {
+    try {
+      hide = m_repo.revparse(since.c_str()).get_id();
+    } catch (const git2wrap::runtime_error& err) {
+      return {};
+    }
+
+    // a rewritten branch can't build on the count of its old tip
+    if (git_oid_equal(hide->ptr(), tip.ptr()) == 0
+        && git_graph_descendant_of(m_repo.get(), tip.ptr(), hide->ptr()) != 1)
+    {
+      return {};
+    }
+  }
+
+  git_revwalk* walk = nullptr;
+  if (git_revwalk_new(&walk, m_repo.get()) != 0) {
+    return {};
+  }
+
+  std::optional<std::size_t> res;
+  if (git_revwalk_push(walk, tip.ptr()) == 0
+      && (!hide || git_revwalk_hide(walk, hide->ptr()) == 0))
+  {
+    std::size_t count = 0;
+
+    git_oid oid = {};
+    while (git_revwalk_next(&oid, walk) == 0) {
+      count++;
+    }
+
+    res = count;
+  }
+
+  git_revwalk_free(walk);
+  return res;
+}
+
+std::string repository::get_refs() const
+{
+  std::string res;
+
+  for (const auto& ref : m_branch_refs) {
+    res += std::format(
+        "branch {} {}\n", ref.name, ref.tip.get_hex_string(shasize)
+    );
+  }
+
+  for (const auto& ref : m_tag_refs) {
+    res += std::format("tag {} {}\n", ref.name, ref.id.get_hex_string(shasize));
+  }
+
+  return res;
 }
 
 std::string repository::read_file(
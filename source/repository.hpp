@@ -1,12 +1,18 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <git2wrap/repository.hpp>
 
+#include "arguments.hpp"
 #include "branch.hpp"
+#include "history.hpp"
 #include "tag.hpp"
 
 namespace startgit
@@ -15,14 +21,16 @@ namespace startgit
 class repository
 {
 public:
-  explicit repository(const std::filesystem::path& path);
+  repository(const std::filesystem::path& path, const arguments_t& args);
   repository(const repository&) = delete;
   repository& operator=(const repository&) = delete;
-  repository(repository&&) = default;
-  repository& operator=(repository&&) = default;
+  // branches and files refer back to the handle and the history
+  repository(repository&&) = delete;
+  repository& operator=(repository&&) = delete;
   ~repository() = default;
 
   const auto& get() const { return m_repo; }
+  const arguments_t& get_args() const { return *m_args; }
   const auto& get_path() const { return m_path; }
 
   const std::string& get_url() const { return m_url; }
@@ -30,14 +38,51 @@ public:
   const std::string& get_owner() const { return m_owner; }
   const std::string& get_description() const { return m_description; }
 
-  const auto& get_branches() const { return m_branches; }
-  const auto& get_tags() const { return m_tags; }
+  struct branch_ref
+  {
+    git2wrap::branch ref;
+    std::string name;
+    git2wrap::oid tip;
+  };
 
-private:
+  // listed up front, without reading any commit
+  const auto& get_branch_refs() const { return m_branch_refs; }
+
+  // only the named branches are built, over the history of their tips
+  // alone, in the order of get_branch_refs(); the first call decides
+  // which branches, later ones return the same
+  const std::vector<branch>& get_branches(
+      const std::unordered_set<std::string>& names
+  ) const;
+
+  // built on first access
+  const std::vector<tag>& get_tags() const;
+
+  // commits reachable from tip but not from since, without looking any
+  // of them up; nullopt if since is missing or not an ancestor of tip
+  std::optional<std::size_t> count_commits(
+      const git2wrap::oid& tip, const std::string& since = ""
+  ) const;
+
+  // one line per branch and tag, changes whenever any ref moves
+  std::string get_refs() const;
+
+  // first line of a metadata file such as url or owner, "Unknown" if absent
   static std::string read_file(
       const std::filesystem::path& base, const char* file
   );
 
+private:
+  struct tag_ref
+  {
+    std::string name;
+    git2wrap::oid id;
+  };
+
+  static constexpr int shasize = 40;
+
+  const arguments_t* m_args;
+
   std::filesystem::path m_path;
   git2wrap::repository m_repo;
 
@@ -47,8 +92,15 @@ private:
   std::string m_owner;
   std::string m_description;
 
-  std::vector<branch> m_branches;
-  std::vector<tag> m_tags;
+  std::vector<branch_ref> m_branch_refs;
+  std::vector<tag_ref> m_tag_refs;
+
+  mutable std::once_flag m_branches_flag;
+  mutable std::unique_ptr<history> m_history;
+  mutable std::vector<branch> m_branches;
+
+  mutable std::once_flag m_tags_flag;
+  mutable std::vector<tag> m_tags;
 };
 
 }  // namespace startgit
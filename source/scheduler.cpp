@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <utility>
+
+#include "scheduler.hpp"
+
+namespace startgit
+{
+
+namespace
+{
+
+thread_local scheduler::worker* current = nullptr;  // NOLINT
+
+}  // namespace
+
+const git2wrap::repository& scheduler::worker::get_repository(
+    const std::filesystem::path& path
+)
+{
+  const auto itr = std::find_if(
+      m_repos.begin(),
+      m_repos.end(),
+      [&](const auto& entry) { return entry.first == path.string(); }
+  );
+
+  if (itr != m_repos.end()) {
+    m_repos.splice(m_repos.begin(), m_repos, itr);
+    return m_repos.front().second;
+  }
+
+  // every handle holds open packs and their mapped windows,
+  // a worker touching many repositories closes the ones it left behind
+  if (m_repos.size() >= max_repos) {
+    m_repos.pop_back();
+  }
+
+  m_repos.emplace_front(
+      path.string(),
+      git2wrap::repository::open(
+          path.c_str(), git2wrap::repository::flags_open::no_search, nullptr
+      )
+  );
+
+  return m_repos.front().second;
+}
+
+scheduler::scheduler(std::size_t jobs)
+{
+  jobs = std::max(jobs, std::size_t {1});
+
+  for (std::size_t i = 0; i < jobs; i++) {
+    m_workers.emplace_back(std::make_unique<worker>())->m_owner = this;
+  }
+
+  for (std::size_t i = 0; i < jobs; i++) {
+    m_threads.emplace_back(&scheduler::work, this, i);
+  }
+}
+
+scheduler::~scheduler()
+{
+  {
+    const std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_task_cond.notify_all();
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+void scheduler::submit(task_t task, std::size_t cost)
+{
+  const auto seq = m_seq++;
+
+  // keep follow-up work local to the worker that produced it
+  worker& wrk = current != nullptr && current->m_owner == this
+      ? *current
+      : *m_workers[seq % m_workers.size()];
+
+  // counted before it can be taken, so a worker never takes a task the
+  // counters don't know about, and wait() can't see zero while the task
+  // submitting this one is still running
+  {
+    const std::lock_guard lock(m_mutex);
+    m_queued++;
+    m_pending++;
+  }
+
+  {
+    const std::lock_guard lock(wrk.m_mutex);
+    wrk.m_tasks.push({cost, seq, std::move(task)});
+  }
+
+  m_task_cond.notify_one();
+}
+
+void scheduler::wait()
+{
+  std::unique_lock lock(m_mutex);
+  m_done_cond.wait(lock, [&]() { return m_pending == 0; });
+
+  if (m_error) {
+    std::rethrow_exception(std::exchange(m_error, nullptr));
+  }
+}
+
+bool scheduler::take(std::size_t idx, task_t& task)
+{
+  // own queue first, then steal going around the other workers
+  for (std::size_t i = 0; i < m_workers.size(); i++) {
+    auto& wrk = *m_workers[(idx + i) % m_workers.size()];
+
+    const std::lock_guard lock(wrk.m_mutex);
+    if (wrk.m_tasks.empty()) {
+      continue;
+    }
+
+    // priority_queue only exposes a const top, the entry is popped anyway
+    auto& top = const_cast<worker::entry&>(wrk.m_tasks.top());  // NOLINT
+    task = std::move(top.task);
+    wrk.m_tasks.pop();
+    return true;
+  }
+
+  return false;
+}
+
+void scheduler::work(std::size_t idx)
+{
+  current = m_workers[idx].get();
+
+  while (true) {
+    task_t task;
+
+    {
+      std::unique_lock lock(m_mutex);
+      m_task_cond.wait(lock, [&]() { return m_stop || m_queued > 0; });
+
+      if (m_stop) {
+        return;
+      }
+    }
+
+    if (!take(idx, task)) {
+      continue;  // someone else was faster
+    }
+
+    {
+      const std::lock_guard lock(m_mutex);
+      m_queued--;
+    }
+
+    try {
+      task(*current);
+    } catch (...) {
+      const std::lock_guard lock(m_mutex);
+      if (!m_error) {
+        m_error = std::current_exception();
+      }
+    }
+
+    {
+      const std::lock_guard lock(m_mutex);
+      m_pending--;
+    }
+
+    m_done_cond.notify_all();
+  }
+}
+
+}  // namespace startgit
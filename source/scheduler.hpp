@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <git2wrap/repository.hpp>
+
+namespace startgit
+{
+
+// Work stealing scheduler shared by all repositories of a run.
+//
+// Every worker owns a queue ordered by the estimated cost of a task, so
+// expensive tasks start first. Tasks submitted from a worker go to its own
+// queue, other ones are spread over all queues. A worker whose queue is
+// empty steals the most expensive task of the next non-empty queue, going
+// around the workers in order.
+class scheduler
+{
+public:
+  class worker
+  {
+  public:
+    // libgit2 objects must not be shared between threads, so every worker
+    // opens each repository on its own. Only the few most recently used
+    // handles are kept open, the reference is valid until the next call.
+    const git2wrap::repository& get_repository(
+        const std::filesystem::path& path
+    );
+
+  private:
+    friend class scheduler;
+
+    struct entry
+    {
+      std::size_t cost;
+      std::size_t seq;
+      std::function<void(worker&)> task;
+
+      bool operator<(const entry& rhs) const
+      {
+        // most expensive first, then in order of submission
+        return cost != rhs.cost ? cost < rhs.cost : seq > rhs.seq;
+      }
+    };
+
+    static constexpr std::size_t max_repos = 4;
+
+    const scheduler* m_owner = nullptr;
+
+    std::mutex m_mutex;
+    std::priority_queue<entry> m_tasks;
+
+    std::list<std::pair<std::string, git2wrap::repository>> m_repos;
+  };
+
+  using task_t = std::function<void(worker&)>;
+
+  explicit scheduler(std::size_t jobs);
+  scheduler(const scheduler&) = delete;
+  scheduler& operator=(const scheduler&) = delete;
+  scheduler(scheduler&&) = delete;
+  scheduler& operator=(scheduler&&) = delete;
+  ~scheduler();
+
+  void submit(task_t task, std::size_t cost = 0);
+
+  // block until every submitted task is done, rethrow the first failure
+  void wait();
+
+private:
+  bool take(std::size_t idx, task_t& task);
+  void work(std::size_t idx);
+
+  std::vector<std::unique_ptr<worker>> m_workers;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_mutex;
+  std::condition_variable m_task_cond;
+  std::condition_variable m_done_cond;
+
+  std::size_t m_queued = 0;
+  std::size_t m_pending = 0;
+  std::exception_ptr m_error;
+  bool m_stop = false;
+
+  std::atomic<std::size_t> m_seq = 0;
+};
+
+}  // namespace startgit
@@ -1,6 +1,14 @@
+#include <algorithm>
+#include <cstdint>
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <git2wrap/error.hpp>
 #include <git2wrap/libgit2.hpp>
@@ -9,68 +17,305 @@
 #include <poafloc/poafloc.hpp>
 
 #include "arguments.hpp"
+#include "commit.hpp"
 #include "document.hpp"
 #include "repository.hpp"
+#include "scheduler.hpp"
+#include "summary.hpp"
+#include "utils.hpp"
 
 namespace startgit
 {
 
-hemplate::element write_table_row(const std::filesystem::path& repo_path)
+// What a row of the index shows, nothing else is read from the repository
+struct probe_t
 {
-  using namespace hemplate::html;  // NOLINT
-
-  try {
-    const repository repo(repo_path);
+  std::string name;
+  std::string description;
+  std::string owner;
+  std::string time;
+  std::int64_t time_raw = 0;
+  std::string warning;
+};
 
-    for (const auto& branch : repo.get_branches()) {
-      if (branch.get_name() != "master") {
-        continue;
-      }
+// Prefer the summary startgit left next to the pages, the repository is
+// only opened for ones that were never rendered by a summary aware run
+probe_t probe(const arguments_t& args, const std::filesystem::path& repo_path)
+{
+  probe_t res;
 
-      const auto url = repo.get_name() + "/master/log.html";
-      return tr {
-          td {aHref {url, repo.get_name()}},
-          td {repo.get_description()},
-          td {repo.get_owner()},
-          td {branch.get_commits()[0].get_time()},
-      };
+  const summary smry(args.output_dir / repo_path.stem() / ".summary");
+  if (smry.is_valid()) {
+    const auto* master = smry.get_branch("master");
+    if (master == nullptr) {
+      res.warning = std::format(
+          "Warning: {} doesn't have master branch\n", repo_path.string()
+      );
+      return res;
     }
 
-    std::cerr << std::format(
-        "Warning: {} doesn't have master branch\n", repo.get_path().string()
+    res.name = smry.get_name();
+    res.description = smry.get_description();
+    res.owner = smry.get_owner();
+    res.time = time_short(master->time);
+    res.time_raw = master->time;
+    return res;
+  }
+
+  try {
+    const auto repo = git2wrap::repository::open(
+        repo_path.c_str(), git2wrap::repository::flags_open::no_search, nullptr
     );
+
+    try {
+      const auto oid = repo.revparse("refs/heads/master").get_id();
+      const commit last(repo.commit_lookup(oid));
+      res.time = last.get_time();
+      res.time_raw = last.get_time_raw();
+    } catch (const git2wrap::error<git2wrap::error_code_t::enotfound>& err) {
+      res.warning = std::format(
+          "Warning: {} doesn't have master branch\n", repo_path.string()
+      );
+      return res;
+    }
   } catch (const git2wrap::error<git2wrap::error_code_t::enotfound>& err) {
-    std::cerr << std::format(
+    res.warning = std::format(
         "Warning: {} is not a repository\n", repo_path.string()
     );
+    return res;
   }
 
-  return element {};
+  res.name = repo_path.stem().string();
+  res.description = repository::read_file(repo_path, "description");
+  res.owner = repository::read_file(repo_path, "owner");
+  return res;
 }
 
-hemplate::element write_table()
+std::string read_page(const std::filesystem::path& path)
+{
+  std::ifstream ifs(path);
+  return {
+      std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()
+  };
+}
+
+// pages whose slice of the index did not change are left alone
+void write_page(
+    const arguments_t& args,
+    const std::filesystem::path& path,
+    const std::string& content
+)
+{
+  if (args.force || read_page(path) != content) {
+    std::ofstream ofs(path);
+    ofs << content;
+  }
+}
+
+std::string page_name(std::size_t page)
+{
+  if (page == 0) {
+    return "index.html";
+  }
+
+  return std::format("index@{}.html", page + 1);
+}
+
+void sort_rows(const arguments_t& args, std::vector<probe_t>& rows)
+{
+  // most recently active first, grouped by owner if asked to
+  std::sort(
+      rows.begin(),
+      rows.end(),
+      [&](const auto& lhs, const auto& rhs)
+      {
+        if (args.index_owner && lhs.owner != rhs.owner) {
+          return lhs.owner < rhs.owner;
+        }
+
+        if (lhs.time_raw != rhs.time_raw) {
+          return lhs.time_raw > rhs.time_raw;
+        }
+
+        return lhs.name < rhs.name;
+      }
+  );
+}
+
+hemplate::element write_table_row(const probe_t& info)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  const auto url = info.name + "/master/log.html";
+  return tr {
+      td {aHref {url, info.name}},
+      td {info.description},
+      td {info.owner},
+      td {info.time},
+  };
+}
+
+hemplate::element write_rows(std::span<const probe_t> rows)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  return table {
+      thead {
+          tr {
+              td {"Name"},
+              td {"Description"},
+              td {"Owner"},
+              td {"Last commit"},
+          },
+      },
+      tbody {
+          transform(rows, write_table_row),
+      },
+  };
+}
+
+hemplate::element write_navigation(std::size_t page, std::size_t pages)
 {
   using namespace hemplate::html;  // NOLINT
 
+  if (pages < 2) {
+    return element {};
+  }
+
+  return p {
+      page > 0 ? aHref {page_name(page - 1), "Previous"} : element {},
+      std::format(" Page {} of {} ", page + 1, pages),
+      page + 1 < pages ? aHref {page_name(page + 1), "Next"} : element {},
+  };
+}
+
+hemplate::element write_table(
+    const arguments_t& args,
+    std::span<const probe_t> rows,
+    std::size_t page,
+    std::size_t pages
+)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  if (!args.index_owner) {
+    return element {
+        h1 {args.title},
+        p {args.description},
+        write_navigation(page, pages),
+        write_rows(rows),
+        write_navigation(page, pages),
+    };
+  }
+
+  // rows are already sorted by owner, split them where it changes
+  std::vector<std::span<const probe_t>> groups;
+  for (std::size_t i = 0, start = 0; i < rows.size(); i++) {
+    if (i + 1 == rows.size() || rows[i + 1].owner != rows[i].owner) {
+      groups.push_back(rows.subspan(start, i + 1 - start));
+      start = i + 1;
+    }
+  }
+
   return element {
       h1 {args.title},
       p {args.description},
-      table {
-          thead {
-              tr {
-                  td {"Name"},
-                  td {"Description"},
-                  td {"Owner"},
-                  td {"Last commit"},
-              },
-          },
-          tbody {
-              transform(args.repos, write_table_row),
-          },
-      }
+      write_navigation(page, pages),
+      transform(
+          groups,
+          [](const auto& group)
+          {
+            return element {
+                h2 {group.front().owner},
+                write_rows(group),
+            };
+          }
+      ),
+      write_navigation(page, pages),
   };
 }
 
+void write_pages(const arguments_t& args, const std::vector<probe_t>& rows)
+{
+  const auto size = std::max<std::size_t>(
+      1, args.index_page == 0 ? rows.size() : args.index_page
+  );
+  const auto pages = std::max<std::size_t>(1, (rows.size() + size - 1) / size);
+
+  const document doc {
+      args,
+      args.title,
+      args.description,
+      args.author,
+      "./",
+      /* has_feed = */ false,
+  };
+
+  for (std::size_t page = 0; page < pages; page++) {
+    const auto begin = std::min(rows.size(), page * size);
+    const auto count = std::min(rows.size() - begin, size);
+    const std::span<const probe_t> slice(rows.data() + begin, count);
+
+    std::ostringstream oss;
+    doc.render(oss, [&]() { return write_table(args, slice, page, pages); });
+    write_page(args, args.output_dir / page_name(page), oss.str());
+  }
+
+  // the index shrank, drop the pages past its end
+  for (std::size_t page = pages;; page++) {
+    if (!std::filesystem::remove(args.output_dir / page_name(page))) {
+      break;
+    }
+  }
+}
+
+void json_string(std::string& out, std::string_view str)
+{
+  out += '"';
+  for (const char chr : str) {
+    switch (chr) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      default:
+        if (static_cast<unsigned char>(chr) < 0x20) {  // NOLINT
+          out += std::format("\\u{:04x}", static_cast<unsigned>(chr));
+        } else {
+          out += chr;
+        }
+        break;
+    }
+  }
+  out += '"';
+}
+
+// the whole index in one small file, for clients that filter on their own
+void write_json(const arguments_t& args, const std::vector<probe_t>& rows)
+{
+  std::string out = "[";
+  for (const auto& info : rows) {
+    if (out.size() > 1) {
+      out += ',';
+    }
+
+    out += "{\"name\":";
+    json_string(out, info.name);
+    out += ",\"description\":";
+    json_string(out, info.description);
+    out += ",\"owner\":";
+    json_string(out, info.owner);
+    out += std::format(",\"time\":{},\"url\":", info.time_raw);
+    json_string(out, info.name + "/master/log.html");
+    out += '}';
+  }
+  out += "]\n";
+
+  write_page(args, args.output_dir / "index.json", out);
+}
+
 }  // namespace startgit
 
 int main(int argc, const char* argv[])
@@ -79,6 +324,7 @@ int main(int argc, const char* argv[])
   using namespace startgit;  // NOLINT
   using namespace poafloc;  // NOLINT
 
+  arguments_t args;
   auto program = parser<arguments_t> {
       positional {
           argument_list {
@@ -98,6 +344,21 @@ int main(int argc, const char* argv[])
               &arguments_t::force,
               "Force write even if file exists",
           },
+          direct {
+              "j jobs",
+              &arguments_t::set_jobs,
+              "N Number of repositories probed at once",
+          },
+          direct {
+              "p page",
+              &arguments_t::set_index_page,
+              "N Repositories per index page, 0 for a single page",
+          },
+          boolean {
+              "O owner",
+              &arguments_t::index_owner,
+              "Group repositories by owner",
+          },
       },
       group {
           "General Information",
@@ -141,19 +402,42 @@ int main(int argc, const char* argv[])
     std::filesystem::create_directories(output_dir);
     output_dir = std::filesystem::canonical(output_dir);
 
-    std::ofstream ofs(args.output_dir / "index.html");
-    const document doc {
-        args.title, args.description, args.author, "./", /* has_feed = */ false
-    };
-    doc.render(ofs, write_table);
+    // repositories are independent, probe them all at once
+    std::vector<probe_t> probes(args.repos.size());
+    {
+      scheduler sched(args.jobs);
+      for (std::size_t i = 0; i < args.repos.size(); i++) {
+        sched.submit(
+            [&, i](auto& /* wrk */) { probes[i] = probe(args, args.repos[i]); }
+        );
+      }
+      sched.wait();
+    }
+
+    // only repositories with a master branch make it into the index
+    std::vector<probe_t> rows;
+    for (auto& info : probes) {
+      std::cerr << info.warning;
+      if (info.warning.empty()) {
+        rows.push_back(std::move(info));
+      }
+    }
+
+    sort_rows(args, rows);
+    write_pages(args, rows);
+    write_json(args, rows);
   } catch (const poafloc::runtime_error& err) {
     std::cerr << std::format("Error (poafloc): {}\n", err.what());
+    return 1;
   } catch (const git2wrap::runtime_error& err) {
     std::cerr << std::format("Error (git2wrap): {}\n", err.what());
+    return 1;
   } catch (const std::runtime_error& err) {
     std::cerr << std::format("Error: {}\n", err.what());
+    return 1;
   } catch (...) {
     std::cerr << std::format("Unknown error\n");
+    return 1;
   }
 
   return 0;
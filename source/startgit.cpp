@@ -1,9 +1,20 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <git2wrap/error.hpp>
 #include <git2wrap/libgit2.hpp>
@@ -16,7 +27,11 @@
 #include "arguments.hpp"
 #include "document.hpp"
 #include "html.hpp"
+#include "manifest.hpp"
+#include "metadata.hpp"
 #include "repository.hpp"
+#include "scheduler.hpp"
+#include "summary.hpp"
 #include "utils.hpp"
 
 using hemplate::element;
@@ -52,6 +67,39 @@ element wtable(
   };
 }
 
+// Same markup as above, rows are written out as soon as they are made
+template<std::ranges::forward_range R>
+void wtable(
+    std::ostream& ost,
+    std::initializer_list<std::string_view> head_content,
+    const R& range,
+    based::Procedure<element, std::ranges::range_value_t<R>> auto proc
+)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  ost << "<table>";
+  ost << thead {
+      tr {
+          transform(
+              head_content,
+              [](const auto& elem)
+              {
+                return td {
+                    elem,
+                };
+              }
+          ),
+      },
+  };
+
+  ost << "<tbody>";
+  for (const auto& item : range) {
+    ost << proc(item);
+  }
+  ost << "</tbody></table>";
+}
+
 }  // namespace
 
 namespace startgit
@@ -59,8 +107,8 @@ namespace startgit
 
 element page_title(
     const repository& repo,
-    const branch& branch,
-    const std::string& relpath = "./"
+    const std::vector<file>& special,
+    const std::string& relpath
 )
 {
   using namespace hemplate::html;  // NOLINT
@@ -87,7 +135,7 @@ element page_title(
                   " | ",
                   aHref {relpath + "refs.html", "Refs"},
                   transform(
-                      branch.get_special(),
+                      special,
                       [&](const auto& file)
                       {
                         auto path = file.get_path();
@@ -108,31 +156,95 @@ element page_title(
   };
 }
 
-element commit_table(const branch& branch)
+element page_title(
+    const repository& repo,
+    const branch& branch,
+    const std::string& relpath = "./"
+)
+{
+  return page_title(repo, branch.get_special(), relpath);
+}
+
+metadata::commit_stats get_stats(
+    const arguments_t& args, metadata& meta, const commit& commit
+)
+{
+  const auto oid = commit.get().get_id();
+  if (const auto stats = meta.get_commit(oid)) {
+    return *stats;
+  }
+
+  const auto dstats = commit.get_stats(args);
+  const metadata::commit_stats stats = {
+      dstats->files,
+      dstats->insertions,
+      dstats->deletions,
+  };
+
+  meta.put_commit(oid, stats);
+  return stats;
+}
+
+metadata::blob_info get_info(
+    const arguments_t& args, metadata& meta, const file& file
+)
+{
+  auto info = meta.get_blob(file.get_id());
+  const bool known = info.has_value();
+
+  if (!known) {
+    info = {file.get_size(), 0, false, false};
+  }
+
+  // large blobs are never inflated just to count their lines
+  if (info->size <= args.file_size && !info->counted) {
+    info->binary = file.is_binary();
+    info->lines =
+        info->binary ? 0 : static_cast<std::uint64_t>(file.get_lines());
+    info->counted = true;
+    file.release();
+  } else if (known) {
+    return *info;
+  }
+
+  meta.put_blob(file.get_id(), *info);
+  return *info;
+}
+
+void write_commit_table(
+    std::ostream& ost,
+    const arguments_t& args,
+    metadata& meta,
+    const branch& branch
+)
 {
   using namespace hemplate::html;  // NOLINT
 
-  return wtable(
+  wtable(
+      ost,
       {"Date", "Commit message", "Author", "Files", "+", "-"},
       branch.get_commits(),
       [&](const auto& commit)
       {
         const auto idd = commit.get_id();
         const auto url = std::format("./commit/{}.html", idd);
+        const auto stats = get_stats(args, meta, commit);
 
         return tr {
             td {commit.get_time()},
             td {aHref {url, commit.get_summary()}},
             td {commit.get_author_name()},
-            td {commit.get_diff().get_files_changed()},
-            td {commit.get_diff().get_insertions()},
-            td {commit.get_diff().get_deletions()},
+            td {std::to_string(stats.files)},
+            td {std::to_string(stats.insertions)},
+            td {std::to_string(stats.deletions)},
         };
       }
   );
 }
 
-element files_table(const branch& branch)
+element files_table(
+    const arguments_t& args, metadata& meta, const branch& branch
+)
 {
   using namespace hemplate::html;  // NOLINT
 
@@ -143,9 +255,11 @@ element files_table(const branch& branch)
       {
         const auto path = file.get_path().string();
         const auto url = std::format("./file/{}.html", path);
-        const auto size = file.is_binary()
-            ? std::format("{}B", file.get_size())
-            : std::format("{}L", file.get_lines());
+
+        const auto info = get_info(args, meta, file);
+        const auto size = info.size > args.file_size || info.binary
+            ? std::format("{}B", info.size)
+            : std::format("{}L", info.lines);
 
         return tr {
             td {file.get_filemode()},
@@ -160,22 +274,23 @@ element branch_table(const repository& repo, const std::string& branch_name)
 {
   using namespace hemplate::html;  // NOLINT
 
+  // only the tips are read, no branch has to be built for this
   return element {
       h2 {"Branches"},
       wtable(
           {"&nbsp;", "Name", "Last commit date", "Author"},
-          repo.get_branches(),
-          [&](const auto& branch)
+          repo.get_branch_refs(),
+          [&](const auto& ref)
           {
-            const auto& last = branch.get_last_commit();
-            const auto url = branch.get_name() != branch_name
-                ? std::format("../{}/refs.html", branch.get_name())
+            const commit last(repo.get().commit_lookup(ref.tip));
+            const auto url = ref.name != branch_name
+                ? std::format("../{}/refs.html", ref.name)
                 : "";
-            const auto name = branch.get_name() == branch_name ? "*" : "&nbsp;";
+            const auto name = ref.name == branch_name ? "*" : "&nbsp;";
 
             return tr {
                 td {name},
-                td {aHref {url, branch.get_name()}},
+                td {aHref {url, ref.name}},
                 td {last.get_time()},
                 td {last.get_author_name()},
             };
@@ -206,143 +321,203 @@ element tag_table(const repository& repo)
   };
 }
 
-element file_changes(const diff& diff)
+void write_file_changes(std::ostream& ost, const diff& diff)
 {
   using namespace hemplate::html;  // NOLINT
 
-  return element {
-      b {"Diffstat:"},
-      wtable(
-          {},
-          diff.get_deltas(),
-          [&](const auto& delta)
-          {
-            static const char* marker = " ADMRC  T  ";
-
-            const std::string link = std::format("#{}", delta->new_file.path);
+  ost << b {"Diffstat:"};
+  wtable(
+      ost,
+      {},
+      diff.get_deltas(),
+      [&](const auto& delta)
+      {
+        static const char* marker = " ADMRC  T  ";
 
-            uint32_t add = delta.get_adds();
-            uint32_t del = delta.get_dels();
-            const uint32_t changed = add + del;
-            const uint32_t total = 80;
-            if (changed > total) {
-              const double percent = 1.0 * total / changed;
+        const std::string link = std::format("#{}", delta->new_file.path);
 
-              if (add > 0) {
-                add = static_cast<uint32_t>(std::lround(percent * add) + 1);
-              }
+        uint32_t add = delta.get_adds();
+        uint32_t del = delta.get_dels();
+        const uint32_t changed = add + del;
+        const uint32_t total = 80;
+        if (changed > total) {
+          const double percent = 1.0 * total / changed;
 
-              if (del > 0) {
-                del = static_cast<uint32_t>(std::lround(percent * del) + 1);
-              }
-            }
+          if (add > 0) {
+            add = static_cast<uint32_t>(std::lround(percent * add) + 1);
+          }
 
-            return tr {
-                td {std::string(1, marker[delta->status])},  // NOLINT
-                td {aHref {link, delta->new_file.path}},
-                td {"|"},
-                td {
-                    span {{{"class", "add"}}, std::string(add, '+')},
-                    span {{{"class", "del"}}, std::string(del, '-')},
-                },
-            };
+          if (del > 0) {
+            del = static_cast<uint32_t>(std::lround(percent * del) + 1);
           }
-      ),
+        }
 
-      p {
-          std::format(
-              "{} files changed, {} insertions(+), {} deletions(-)",
-              diff.get_files_changed(),
-              diff.get_insertions(),
-              diff.get_deletions()
-          ),
-      },
+        return tr {
+            td {std::string(1, marker[delta->status])},  // NOLINT
+            td {aHref {link, delta->new_file.path}},
+            td {"|"},
+            td {
+                span {{{"class", "add"}}, std::string(add, '+')},
+                span {{{"class", "del"}}, std::string(del, '-')},
+            },
+        };
+      }
+  );
+
+  // lines are only known for the files whose patch was generated
+  const auto& deltas = diff.get_deltas();
+  const auto shown = static_cast<std::size_t>(std::ranges::count_if(
+      deltas, [](const auto& dlt) { return dlt.is_loaded(); }
+  ));
+
+  ost << p {
+      std::format(
+          "{} files changed, {} insertions(+), {} deletions(-){}",
+          deltas.size(),
+          diff.get_insertions(),
+          diff.get_deletions(),
+          shown < deltas.size()
+              ? std::format(" in the first {} files", shown)
+              : ""
+      ),
   };
 }
 
-element diff_hunk(const hunk& hunk)
+void write_file_diffs(
+    std::ostream& ost, const arguments_t& args, const diff& diff
+)
 {
   using namespace hemplate::html;  // NOLINT
 
-  const std::string header(hunk->header);  // NOLINT
-  return element {
-      h4 {
-          std::format(
-              "@@ -{},{} +{},{} @@ ",
-              hunk->old_start,
-              hunk->old_lines,
-              hunk->new_start,
-              hunk->new_lines
-          ),
-          xmlencode(header.substr(header.rfind('@') + 2)),
-      },
-      span {
-          transform(
-              hunk.get_lines(),
-              [](const auto& line) -> element
-              {
-                using hemplate::html::div;
+  static const std::size_t flush_size = std::size_t {64} << 10U;
 
-                if (line.is_add()) {
-                  return div {
-                      {{"class", "inline add"}},
-                      xmlencode(line.get_content()),
-                  };
-                }
+  // lines are escaped straight out of libgit2's buffers into this one
+  std::string buffer;
+  buffer.reserve(flush_size * 2);
+  std::size_t written = 0;
 
-                if (line.is_del()) {
-                  return div {
-                      {{"class", "inline del"}},
-                      xmlencode(line.get_content()),
-                  };
-                }
+  const auto flush = [&]()
+  {
+    ost.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    written += buffer.size();
+    buffer.clear();
+  };
 
-                return div {
-                    {{"class", "inline"}},
-                    xmlencode(line.get_content()),
-                };
-              }
-          ),
-      },
+  // lines of a hunk are wrapped in a span that is closed by the next one
+  bool in_hunk = false;
+  const auto close_hunk = [&]()
+  {
+    if (std::exchange(in_hunk, false)) {
+      buffer += "</span>";
+    }
+    flush();
   };
-}
 
-element file_diffs(const diff& diff)
-{
-  using namespace hemplate::html;  // NOLINT
+  // deltas over a limit keep their header, but none of their lines
+  bool skip = false;
 
-  return transform(
-      diff.get_deltas(),
-      [](const auto& delta)
-      {
-        const auto& new_file = delta->new_file.path;
-        const auto& old_file = delta->new_file.path;
-        const auto new_link = std::format("../file/{}.html", new_file);
-        const auto old_link = std::format("../file/{}.html", old_file);
+  const auto too_large = [&]()
+  {
+    close_hunk();
+    ost << p {"Diff too large"};
+    skip = true;
+  };
 
-        return element {
-            h3 {
-                {{"id", delta->new_file.path}},
-                "diff --git",
-                "a/",
-                aHref {new_link, new_file},
-                "b/",
-                aHref {old_link, old_file},
-            },
-            transform(delta.get_hunks(), diff_hunk),
-        };
-      }
-  );
+  const auto& deltas = diff.get_deltas();
+  for (std::size_t idx = 0; idx < deltas.size(); idx++) {
+    const auto& dlt = deltas[idx];
+    const auto& delta = dlt.get();
+
+    close_hunk();
+    skip = false;
+
+    const auto& new_file = delta.new_file.path;
+    const auto& old_file = delta.new_file.path;
+    const auto new_link = std::format("../file/{}.html", new_file);
+    const auto old_link = std::format("../file/{}.html", old_file);
+
+    ost << h3 {
+        {{"id", delta.new_file.path}},
+        "diff --git",
+        "a/",
+        aHref {new_link, new_file},
+        "b/",
+        aHref {old_link, old_file},
+    };
+
+    const auto lines = dlt.get_adds() + dlt.get_dels();
+    if (!dlt.is_loaded() || lines > args.diff_lines
+        || delta.old_file.size > args.diff_blob
+        || delta.new_file.size > args.diff_blob
+        || written >= args.diff_page)
+    {
+      too_large();
+      continue;
+    }
+
+    // the same patch that was counted for the diffstat
+    dlt.visit({
+        [&](const git_diff_hunk& hunk)
+        {
+          if (skip) {
+            return;
+          }
+
+          close_hunk();
+
+          const std::string header(hunk.header);  // NOLINT
+          ost << h4 {
+              std::format(
+                  "@@ -{},{} +{},{} @@ ",
+                  hunk.old_start,
+                  hunk.old_lines,
+                  hunk.new_start,
+                  hunk.new_lines
+              ),
+              xmlencode(header.substr(header.rfind('@') + 2)),
+          };
+
+          ost << "<span>";
+          in_hunk = true;
+        },
+        [&](const git_diff_line& line)
+        {
+          if (skip) {
+            return;
+          }
+
+          if (written + buffer.size() >= args.diff_page) {
+            too_large();
+            return;
+          }
+
+          buffer += line.origin == '+' ? R"(<div class="inline add">)"
+              : line.origin == '-'     ? R"(<div class="inline del">)"
+                                       : R"(<div class="inline">)";
+          xmlencode(buffer, std::string_view(line.content, line.content_len));
+          buffer += "</div>";
+
+          if (buffer.size() >= flush_size) {
+            flush();
+          }
+        },
+    });
+  }
+
+  close_hunk();
 }
 
-element commit_diff(const commit& commit)
+void write_commit_diff(
+    std::ostream& ost, const arguments_t& args, const commit& commit
+)
 {
   using namespace hemplate::html;  // NOLINT
 
   const auto url = std::format("../commit/{}.html", commit.get_id());
   const auto mailto = std::string("mailto:") + commit.get_author_email();
+  const auto diff = commit.get_diff(args);
 
-  return element {
+  ost << element {
       table {
           tbody {
               tr {
@@ -379,64 +554,95 @@ element commit_diff(const commit& commit)
           {{"class", "inline"}},
           xmlencode(commit.get_message()),
       },
-      file_changes(commit.get_diff()),
-      hr {},
-      file_diffs(commit.get_diff()),
   };
+
+  // every patch is generated once, for the diffstat and the page alike,
+  // and only for the files that can still be shown: past the file limit
+  // or once the patches add up to the page limit, deltas keep their header
+  const auto& deltas = diff->get_deltas();
+  std::size_t size = 0;
+  for (std::size_t idx = 0; idx < deltas.size(); idx++) {
+    if (idx >= args.diff_files || size >= args.diff_page) {
+      break;
+    }
+
+    diff->load(idx);
+    size += deltas[idx].get_size();
+  }
+
+  write_file_changes(ost, *diff);
+  ost << hr {};
+  write_file_diffs(ost, args, *diff);
 }
 
-element write_file_title(const file& file)
+element write_file_title(const file& file, git2wrap::object_size_t size)
 {
   using namespace hemplate::html;  // NOLINT
 
   const auto path = file.get_path().filename().string();
 
   return element {
-      h3 {std::format("{} ({}B)", path, file.get_size())},
+      h3 {std::format("{} ({}B)", path, size)},
       hr {},
   };
 }
 
-element write_file_content(const file& file)
+void write_file_lines(std::ostream& ost, std::string_view text, int count)
 {
-  using namespace hemplate::html;  // NOLINT
+  static const std::size_t flush_size = std::size_t {64} << 10U;
 
-  if (file.is_binary()) {
-    return h4("Binary file");
+  // lines are cut straight out of the blob, only the buffer ever grows
+  std::string buffer;
+  buffer.reserve(flush_size * 2);
+  buffer += "<span>";
+
+  const char* crnt = text.data();
+  const char* const end = crnt + text.size();  // NOLINT
+
+  for (; crnt != end; count++) {
+    const auto* eol = static_cast<const char*>(
+        std::memchr(crnt, '\n', static_cast<std::size_t>(end - crnt))
+    );
+    if (eol == nullptr) {
+      eol = end;
+    }
+
+    std::format_to(
+        std::back_inserter(buffer),
+        R"(<div class="inline"><a id="{0}" href="#{0}">{0:5}</a> )",
+        count
+    );
+    xmlencode(buffer, std::string_view(crnt, eol));
+    buffer += "</div>";
+
+    if (buffer.size() >= flush_size) {
+      ost.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      buffer.clear();
+    }
+
+    crnt = eol == end ? end : eol + 1;  // NOLINT
   }
 
-  const std::string str(file.get_content(), file.get_size());
-  std::stringstream sstr(str);
+  buffer += "</span>";
+  ost.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
 
-  std::vector<std::string> lines;
-  std::string tmp;
+void write_file_content(std::ostream& ost, const file& file)
+{
+  using namespace hemplate::html;  // NOLINT
 
-  while (std::getline(sstr, tmp, '\n')) {
-    lines.emplace_back(std::move(tmp));
+  if (file.is_binary()) {
+    ost << h4("Binary file");
+    return;
   }
 
-  int count = 0;
-  return span {
-      transform(
-          lines,
-          [&](const auto& line)
-          {
-            return hemplate::html::div {
-                {{"class", "inline"}},
-                std::format(
-                    R"(<a id="{0}" href="#{0}">{0:5}</a> {1})",
-                    count++,
-                    xmlencode(line)
-                )
-            };
-          }
-      ),
-  };
+  write_file_lines(ost, {file.get_content(), file.get_size()}, 0);
 }
 
 void write_log(
     const std::filesystem::path& base,
     const repository& repo,
+    metadata& meta,
     const branch& branch
 )
 {
@@ -444,12 +650,10 @@ void write_log(
   document(repo, branch, "Commit list")
       .render(
           ofs,
-          [&]()
+          [&](std::ostream& ost)
           {
-            return element {
-                page_title(repo, branch),
-                commit_table(branch),
-            };
+            ost << page_title(repo, branch);
+            write_commit_table(ost, repo.get_args(), meta, branch);
           }
       );
 }
@@ -457,6 +661,7 @@ void write_log(
 void write_file(
     const std::filesystem::path& base,
     const repository& repo,
+    metadata& meta,
     const branch& branch
 )
 {
@@ -467,7 +672,7 @@ void write_file(
       {
         return element {
             page_title(repo, branch),
-            files_table(branch),
+            files_table(repo.get_args(), meta, branch),
         };
       }
   );
@@ -476,202 +681,905 @@ void write_file(
 void write_refs(
     const std::filesystem::path& base,
     const repository& repo,
-    const branch& branch
+    const repository::branch_ref& ref
 )
 {
+  // the branch may not have been built, its special files are read
+  // straight from the root of its tree
+  const auto& args = repo.get_args();
+  const commit last(repo.get().commit_lookup(ref.tip));
+  const auto special =
+      branch::find_special(repo.get(), last.get_tree(), args.special);
+
   std::ofstream ofs(base / "refs.html");
-  document {repo, branch, "Refs list"}.render(
+  document {repo, ref, "Refs list"}.render(
       ofs,
       [&]()
       {
         return element {
-            page_title(repo, branch),
-            branch_table(repo, branch.get_name()),
+            page_title(repo, special, "./"),
+            branch_table(repo, ref.name),
             tag_table(repo),
         };
       }
   );
 }
 
-bool write_commits(
+void link_commit(
+    const std::filesystem::path& store, const std::filesystem::path& page
+)
+{
+  std::error_code err;
+  if (std::filesystem::equivalent(store, page, err)) {
+    return;
+  }
+
+  std::filesystem::remove(page);
+  std::filesystem::create_hard_link(store, page, err);
+  if (err) {
+    // filesystem without hard links, fall back to a symlink
+    std::filesystem::create_symlink(
+        std::filesystem::relative(store, page.parent_path()), page
+    );
+  }
+}
+
+// hands a page over to a worker, along with its estimated cost
+using page_task = std::function<void(const git2wrap::repository&)>;
+using spawn_t = std::function<void(page_task, std::size_t)>;
+
+// a branch page and the page in the store it is linked to
+using commit_link = std::pair<std::filesystem::path, std::filesystem::path>;
+
+void write_commit(
+    const spawn_t& spawn,
+    const std::filesystem::path& store,
     const std::filesystem::path& base,
     const repository& repo,
-    const branch& branch
+    const metadata& meta,
+    const commit& commit,
+    std::unordered_set<std::string>& rendered,
+    std::vector<commit_link>& links
 )
 {
-  bool changed = false;
+  const auto idd = commit.get_id();
+  const auto path = store / (idd + ".html");
+
+  // commit pages are branch agnostic, render each one once per repository
+  const bool stale =
+      repo.get_args().force || !std::filesystem::exists(path);
+  if (stale && rendered.insert(idd).second) {
+    // stats of a previous run tell how big the diff is, so large pages
+    // start first, commits never seen before are assumed to be small
+    const auto stats = meta.get_commit(commit.get().get_id());
+    const auto cost = stats ? 1 + stats->insertions + stats->deletions : 1;
+
+    spawn(
+        [&repo, path, oid = commit.get().get_id()](const auto& handle)
+        {
+          const startgit::commit local(handle.commit_lookup(oid));
 
-  for (const auto& commit : branch.get_commits()) {
-    const std::string file = base / (commit.get_id() + ".html");
-    if (!args.force && std::filesystem::exists(file)) {
-      break;
-    }
+          // only a complete page is moved into the store, an interrupted
+          // run leaves the old one or none, never a partial one
+          auto temp = path;
+          temp += ".tmp";
 
-    std::ofstream ofs(file);
-    document {repo, branch, commit.get_summary(), "../"}.render(
-        ofs,
-        [&]()
-        {
-          return element {
-              page_title(repo, branch, "../"),
-              commit_diff(commit),
-          };
-        }
+          {
+            std::ofstream ofs(temp);
+            document {repo, local.get_summary(), "../"}.render(
+                ofs,
+                [&](std::ostream& ost)
+                {
+                  static const std::vector<file> special;
+                  ost << page_title(repo, special, "../");
+                  write_commit_diff(ost, repo.get_args(), local);
+                }
+            );
+          }
+
+          std::filesystem::rename(temp, path);
+        },
+        cost
     );
-    changed = true;
   }
 
-  return changed;
+  // linked once every page is in the store, see write_indexes
+  links.emplace_back(path, base / (idd + ".html"));
 }
 
-void write_files(
+std::optional<tree_changes> get_tree_changes(
+    const repository& repo, const std::string& tree, const commit& last
+)
+{
+  const auto& args = repo.get_args();
+  if (args.force || tree.empty()) {
+    return {};
+  }
+
+  try {
+    const auto& grepo = repo.get();
+    const auto old_id = grepo.revparse(tree.c_str()).get_id();
+    const auto old_tree = grepo.tree_lookup(old_id);
+    tree_changes changes(old_tree, last.get_tree());
+
+    // every page links to the special files, so all of them need updating
+    const auto is_special = [&](const auto& path)
+    { return args.special.contains(path); };
+
+    if (std::ranges::any_of(changes.added, is_special)
+        || std::ranges::any_of(changes.deleted, is_special))
+    {
+      return {};
+    }
+
+    return changes;
+  } catch (const git2wrap::runtime_error& err) {
+    // previous tree no longer exists, render everything
+    return {};
+  }
+}
+
+// page of one part of a file, large files can be split into several
+std::filesystem::path file_part(
+    const std::filesystem::path& base, const std::string& name, std::size_t part
+)
+{
+  if (part == 0) {
+    return base / (name + ".html");
+  }
+
+  return base / std::format("{}@{}.html", name, part + 1);
+}
+
+void remove_parts(const std::filesystem::path& base, const std::string& name)
+{
+  for (std::size_t part = 1;; part++) {
+    if (!std::filesystem::remove(file_part(base, name, part))) {
+      break;
+    }
+  }
+}
+
+void remove_file(const std::filesystem::path& base, const std::string& name)
+{
+  std::filesystem::path path = base / (name + ".html");
+  std::filesystem::remove(path);
+  remove_parts(base, name);
+
+  // prune directories left empty
+  std::error_code err;
+  for (path = path.parent_path(); path != base; path = path.parent_path()) {
+    if (!std::filesystem::is_empty(path, err) || err) {
+      break;
+    }
+    std::filesystem::remove(path);
+  }
+}
+
+struct file_page
+{
+  std::filesystem::path base;
+  const branch* brnch;
+  const file* fil;
+};
+
+// file pages waiting to be written, grouped by blob id
+using file_pages = std::unordered_map<std::string, std::vector<file_page>>;
+
+void collect_files(
+    file_pages& pages,
     const std::filesystem::path& base,
-    const repository& repo,
-    const branch& branch
+    const branch& branch,
+    const tree_changes* changes
 )
 {
+  if (changes != nullptr) {
+    for (const auto& name : changes->deleted) {
+      remove_file(base, name);
+    }
+  }
+
   for (const auto& file : branch.get_files()) {
-    const std::filesystem::path path =
-        base / (file.get_path().string() + ".html");
-    std::filesystem::create_directories(path.parent_path());
-    std::ofstream ofs(path);
-
-    std::string relpath = "../";
-    for (const char chr : file.get_path().string()) {
-      if (chr == '/') {
-        relpath += "../";
+    if (changes != nullptr) {
+      const auto name = file.get_path().string();
+      if (!changes->added.contains(name) && !changes->modified.contains(name))
+      {
+        continue;
       }
     }
 
-    document {repo, branch, file.get_path().string(), relpath}.render(
-        ofs,
-        [&]()
-        {
-          return element {
-              page_title(repo, branch, relpath),
-              write_file_title(file),
-              write_file_content(file),
+    const auto idd = file.get_id().get_hex_string(40);  // NOLINT
+    pages[idd].push_back({base, &branch, &file});
+  }
+}
+
+// copy part of an already written page, without holding all of it
+void copy_range(
+    std::ostream& ost,
+    const std::filesystem::path& path,
+    std::streamoff begin,
+    std::streamoff length
+)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  ifs.seekg(begin);
+
+  std::array<char, std::size_t {1} << 16U> buffer {};  // NOLINT
+  while (length > 0 && ifs) {
+    const auto chunk =
+        std::min(length, static_cast<std::streamoff>(buffer.size()));
+    ifs.read(buffer.data(), chunk);
+    ost.write(buffer.data(), ifs.gcount());
+    length -= ifs.gcount();
+  }
+}
+
+void write_file_page(
+    const repository& repo,
+    const file_page& page,
+    git2wrap::object_size_t size,
+    std::size_t part,
+    std::size_t parts,
+    const document::stream_t& body
+)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  const auto& branch = *page.brnch;
+  const auto& file = *page.fil;
+  const auto name = file.get_path().string();
+
+  const auto path = file_part(page.base, name, part);
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream ofs(path);
+
+  std::string relpath = "../";
+  for (const char chr : name) {
+    if (chr == '/') {
+      relpath += "../";
+    }
+  }
+
+  const auto link = [&](std::size_t idx, const char* text)
+  {
+    const auto url = file_part("", file.get_path().filename().string(), idx);
+    return aHref {url.string(), text};
+  };
+
+  document {repo, branch, name, relpath}.render(
+      ofs,
+      [&](std::ostream& ost)
+      {
+        ost << page_title(repo, branch, relpath);
+        ost << write_file_title(file, size);
+
+        if (parts > 1) {
+          ost << p {
+              part > 0 ? link(part - 1, "Previous") : element {},
+              std::format(" Part {} of {} ", part + 1, parts),
+              part + 1 < parts ? link(part + 1, "Next") : element {},
           };
         }
+
+        body(ost);
+      }
+  );
+}
+
+// split text into parts of at most count lines each
+std::vector<std::string_view> split_lines(
+    std::string_view text, std::size_t count
+)
+{
+  std::vector<std::string_view> res;
+
+  while (!text.empty()) {
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < count && pos < text.size(); i++) {
+      const auto eol = text.find('\n', pos);
+      pos = eol == std::string_view::npos ? text.size() : eol + 1;
+    }
+
+    res.push_back(text.substr(0, pos));
+    text.remove_prefix(pos);
+  }
+
+  return res;
+}
+
+void write_files(
+    const spawn_t& spawn, const repository& repo, const file_pages& pages
+)
+{
+  using namespace hemplate::html;  // NOLINT
+
+  for (const auto& [idd, group] : pages) {
+    spawn(
+        [&repo, &group](const auto& handle)
+        {
+          const auto& args = repo.get_args();
+
+          // the size comes from the object header,
+          // the blob is only inflated when its content is shown
+          const auto& first = *group.front().fil;
+          first.read_header(handle);
+
+          const auto size = first.get_size();
+          const bool large = size > args.file_size;
+          if (args.file_chunk != 0) {
+            for (const auto& page : group) {
+              remove_parts(page.base, page.fil->get_path().string());
+            }
+          }
+
+          // a large blob is only inflated once it is known to be text,
+          // one that can't be checked cheaply is treated as binary
+          if (large
+              && (args.file_chunk == 0
+                  || first.sniff_binary(handle).value_or(true)))
+          {
+            for (const auto& page : group) {
+              write_file_page(
+                  repo,
+                  page,
+                  size,
+                  0,
+                  1,
+                  [](std::ostream& ost) { ost << h4 {"File too large"}; }
+              );
+            }
+            return;
+          }
+
+          first.load(handle);
+
+          if (large) {
+            const auto parts = split_lines(
+                {first.get_content(), first.get_size()}, args.file_chunk
+            );
+
+            for (std::size_t part = 0; part < parts.size(); part++) {
+              const auto count = static_cast<int>(part * args.file_chunk);
+
+              for (const auto& page : group) {
+                write_file_page(
+                    repo,
+                    page,
+                    size,
+                    part,
+                    parts.size(),
+                    [&](std::ostream& ost)
+                    { write_file_lines(ost, parts[part], count); }
+                );
+              }
+            }
+
+            first.release();
+            return;
+          }
+
+          // the body depends only on the blob, render it once into the
+          // first page and copy it from there into the rest of them
+          std::filesystem::path source;
+          std::streamoff begin = 0;
+          std::streamoff length = 0;
+
+          for (const auto& page : group) {
+            write_file_page(
+                repo,
+                page,
+                size,
+                0,
+                1,
+                [&](std::ostream& ost)
+                {
+                  if (!source.empty()) {
+                    copy_range(ost, source, begin, length);
+                    return;
+                  }
+
+                  begin = ost.tellp();
+                  write_file_content(ost, first);
+                  length = ost.tellp() - begin;
+                }
+            );
+
+            if (source.empty()) {
+              source = file_part(page.base, page.fil->get_path().string(), 0);
+              first.release();
+            }
+          }
+        },
+        group.size()
     );
   }
 }
 
 void write_special(
+    const spawn_t& spawn,
     const std::filesystem::path& base,
     const repository& repo,
     const branch& branch
 )
 {
   for (const auto& file : branch.get_special()) {
-    std::ofstream ofs(base / file.get_path().replace_extension("html"));
-    document {repo, branch, file.get_path().string()}.render(
-        ofs,
-        [&]()
+    const auto path = base / file.get_path().replace_extension("html");
+
+    spawn(
+        [&repo, &branch, &file, path](const auto& handle)
         {
-          std::string html;
+          file.load(handle);
 
-          static const auto process_output =
-              +[](const MD_CHAR* str, MD_SIZE size, void* data)
-          {
-            auto& buffer = *static_cast<std::string*>(data);
-            buffer += std::string(str, size);
-          };
+          std::ofstream ofs(path);
+          document {repo, branch, file.get_path().string()}.render(
+              ofs,
+              [&]()
+              {
+                std::string html;
 
-          md_html(
-              file.get_content(),
-              static_cast<MD_SIZE>(file.get_size()),
-              process_output,
-              &html,
-              MD_DIALECT_GITHUB,
-              0
+                static const auto process_output =
+                    +[](const MD_CHAR* str, MD_SIZE size, void* data)
+                {
+                  auto& buffer = *static_cast<std::string*>(data);
+                  buffer += std::string(str, size);
+                };
+
+                md_html(
+                    file.get_content(),
+                    static_cast<MD_SIZE>(file.get_size()),
+                    process_output,
+                    &html,
+                    repo.get_args(),
+                    MD_DIALECT_GITHUB,
+                    0
+                );
+                return element {
+                    page_title(repo, branch),
+                    html,
+                };
+              }
           );
-          return element {
-              page_title(repo, branch),
-              html,
-          };
-        }
+          file.release();
+        },
+        1
     );
   }
 }
 
 void write_atom(
-    std::ostream& ost, const branch& branch, const std::string& base_url
+    std::ostream& ost,
+    const arguments_t& args,
+    const branch& branch,
+    const std::string& base_url
 )
 {
   using namespace hemplate::atom;  // NOLINT
   using hemplate::atom::link;
 
-  ost << feed {
-      title {args.title},
-      subtitle {args.description},
-      id {base_url + '/'},
-      updated {format_time_now()},
-      author {name {args.author}},
-      linkSelf {base_url + "/atom.xml"},
-      linkAlternate {args.resource_url},
-      transform(
-          branch.get_commits(),
-          [&](const auto& commit)
-          {
-            const auto url =
-                std::format("{}/commit/{}.html", base_url, commit.get_id());
-
-            return entry {
-                id {url},
-                updated {format_time(commit.get_time_raw())},
-                title {commit.get_summary()},
-                linkHref {url},
-                author {
-                    name {commit.get_author_name()},
-                    email {commit.get_author_email()},
-                },
-                content {commit.get_message()},
-            };
-          }
-      ),
+  // entries are written out one commit at a time
+  const auto shell = [&](element entries) -> element
+  {
+    return feed {
+        title {args.title},
+        subtitle {args.description},
+        id {base_url + '/'},
+        updated {format_time_now()},
+        author {name {args.author}},
+        linkSelf {base_url + "/atom.xml"},
+        linkAlternate {args.resource_url},
+        std::move(entries),
+    };
   };
+
+  render_around(
+      ost,
+      shell,
+      [&](std::ostream& out)
+      {
+        for (const auto& commit : branch.get_commits()) {
+          const auto url =
+              std::format("{}/commit/{}.html", base_url, commit.get_id());
+
+          out << entry {
+              id {url},
+              updated {format_time(commit.get_time_raw())},
+              title {commit.get_summary()},
+              linkHref {url},
+              author {
+                  name {commit.get_author_name()},
+                  email {commit.get_author_email()},
+              },
+              content {commit.get_message()},
+          };
+        }
+      }
+  );
 }
 
 void write_rss(
-    std::ostream& ost, const branch& branch, const std::string& base_url
+    std::ostream& ost,
+    const arguments_t& args,
+    const branch& branch,
+    const std::string& base_url
 )
 {
   using namespace hemplate::rss;  // NOLINT
   using hemplate::rss::link;
   using hemplate::rss::rss;
 
+  // items are written out one commit at a time
+  const auto shell = [&](element items) -> element
+  {
+    return rss {
+        channel {
+            title {args.title},
+            description {args.description},
+            link {base_url + '/'},
+            generator {"startgit"},
+            language {"en-us"},
+            atomLink {base_url + "/atom.xml"},
+            std::move(items),
+        },
+    };
+  };
+
   ost << xml {};
-  ost << rss {
-      channel {
-          title {args.title},
-          description {args.description},
-          link {base_url + '/'},
-          generator {"startgit"},
-          language {"en-us"},
-          atomLink {base_url + "/atom.xml"},
-          transform(
-              branch.get_commits(),
-              [&](const auto& commit)
-              {
-                const auto url =
-                    std::format("{}/commit/{}.html", base_url, commit.get_id());
-
-                return item {
-                    title {commit.get_summary()},
-                    link {url},
-                    guid {url},
-                    pubDate {format_time(commit.get_time_raw())},
-                    author {std::format(
-                        "{} ({})",
-                        commit.get_author_email(),
-                        commit.get_author_name()
-                    )},
-                };
-              }
-          ),
-      },
+  render_around(
+      ost,
+      shell,
+      [&](std::ostream& out)
+      {
+        for (const auto& commit : branch.get_commits()) {
+          const auto url =
+              std::format("{}/commit/{}.html", base_url, commit.get_id());
+
+          out << item {
+              title {commit.get_summary()},
+              link {url},
+              guid {url},
+              pubDate {format_time(commit.get_time_raw())},
+              author {std::format(
+                  "{} ({})",
+                  commit.get_author_email(),
+                  commit.get_author_name()
+              )},
+          };
+        }
+      }
+  );
+}
+
+struct branch_state
+{
+  std::filesystem::path base;
+  manifest mfst;
+  const branch* brnch = nullptr;  // only built for a tip that moved
+  bool refs_changed = false;
+  bool tip_changed = false;
+  bool tree_changed = false;
+};
+
+// Everything a repository needs until its last page is written
+struct repository_job
+{
+  repository_job(const arguments_t& args, const std::filesystem::path& path)
+      : repo(path, args)
+      , base(args.output_dir / repo.get_name())
+      , store(base / ".commit")
+      , meta(base / ".metadata", args.diff_blob)
+  {
+  }
+
+  repository repo;
+  std::filesystem::path base;
+  std::filesystem::path store;
+  metadata meta;
+
+  std::vector<branch_state> states;
+  std::unordered_set<std::string> rendered;
+  std::vector<commit_link> links;
+  file_pages files;
+
+  // pages still in flight, plus one held while they are being spawned
+  std::atomic<std::size_t> pending = 1;
+};
+
+// set by any task that failed, so the run as a whole can report it
+std::atomic<bool>& failed()
+{
+  static std::atomic<bool> flag = false;
+  return flag;
+}
+
+template<typename F>
+void report(const std::filesystem::path& path, F func)
+{
+  try {
+    func();
+  } catch (const git2wrap::error<git2wrap::error_code_t::enotfound>& err) {
+    std::cerr << std::format(
+        "Warning: {} is not a repository\n", path.string()
+    );
+  } catch (const git2wrap::runtime_error& err) {
+    std::cerr << std::format(
+        "Error (git2wrap): {}: {}\n", path.string(), err.what()
+    );
+    failed() = true;
+  } catch (const std::runtime_error& err) {
+    std::cerr << std::format("Error: {}: {}\n", path.string(), err.what());
+    failed() = true;
+  }
+}
+
+// rough size of a repository, so the big ones get started first
+std::size_t estimate_cost(const std::filesystem::path& path)
+{
+  std::size_t cost = 1;
+
+  for (const auto* pack : {"objects/pack", ".git/objects/pack"}) {
+    std::error_code err;
+    for (std::filesystem::directory_iterator itr(path / pack, err), end;
+         !err && itr != end;
+         itr.increment(err))
+    {
+      const auto size = itr->file_size(err);
+      cost += err ? 0 : size >> 10U;  // NOLINT
+    }
+  }
+
+  return cost;
+}
+
+// Split one budget between libgit2's object cache, its mapped pack
+// windows and the diff stats cache. Only these caches are bounded: the
+// history, the file lists of the branches being rendered and the metadata
+// records still grow with the size of a repository.
+void set_memory_budget(arguments_t& args)
+{
+  const auto budget = args.memory_budget;
+  if (budget == 0) {
+    return;
+  }
+
+  const auto objects = budget / 4;
+  const auto windows = budget / 2;
+  const auto diffs = budget - objects - windows;
+
+  git_libgit2_opts(
+      GIT_OPT_SET_CACHE_MAX_SIZE, static_cast<ssize_t>(objects)  // NOLINT
+  );
+  git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, windows);  // NOLINT
+
+  args.diff_cache = std::min(args.diff_cache, diffs);
+}
+
+void write_summary(const repository_job& job)
+{
+  const auto& repo = job.repo;
+
+  summary smry(job.base / ".summary");
+  smry.set_name(repo.get_name());
+  smry.set_url(repo.get_url());
+  smry.set_owner(repo.get_owner());
+  smry.set_description(repo.get_description());
+
+  // built from scratch, the branches read from the file are replaced
+  std::vector<summary::branch_info> branches;
+  const auto& refs = repo.get_branch_refs();
+  for (std::size_t i = 0; i < refs.size(); i++) {
+    const auto& ref = refs[i];
+    const auto& state = job.states[i];  // states line up with the refs
+
+    const commit last(repo.get().commit_lookup(ref.tip));
+    const auto idd = last.get_id();
+
+    const auto* prev = smry.get_branch(ref.name);
+    std::optional<std::size_t> count;
+
+    // a branch built this run is counted from its history, an unchanged
+    // tip keeps its count, a fast-forward only walks the commits on top
+    // of the previous one, anything else is counted again
+    if (state.brnch != nullptr) {
+      count = state.brnch->get_commits().size();
+    } else if (prev != nullptr && prev->tip == idd) {
+      count = prev->commits;
+    } else if (prev != nullptr) {
+      if (const auto added = repo.count_commits(ref.tip, prev->tip)) {
+        count = prev->commits + *added;
+      }
+    }
+
+    if (!count) {
+      count = repo.count_commits(ref.tip);
+    }
+
+    branches.push_back({ref.name, idd, last.get_time_raw(), count.value_or(0)});
+  }
+
+  smry.set_branches(std::move(branches));
+  smry.write();
+}
+
+void write_indexes(repository_job& job)
+{
+  const auto& args = job.repo.get_args();
+
+  // a page whose render failed stays unlinked, the next run retries it
+  for (const auto& [store, page] : job.links) {
+    if (std::filesystem::exists(store)) {
+      link_commit(store, page);
+    }
+  }
+
+  // indexes and feeds, once all the pages they refer to are in place
+  for (const auto& state : job.states) {
+    const auto& base_branch = state.base;
+
+    if (state.brnch != nullptr) {
+      const auto& branch = *state.brnch;
+      write_log(base_branch, job.repo, job.meta, branch);
+
+      if (state.tree_changed) {
+        write_file(base_branch, job.repo, job.meta, branch);
+      }
+
+      const std::string relative =
+          std::filesystem::relative(base_branch, args.output_dir);
+      const auto absolute = "https://git.dimitrijedobrota.com/" + relative;
+
+      std::ofstream atom(base_branch / "atom.xml");
+      write_atom(atom, args, branch, absolute);
+
+      std::ofstream rss(base_branch / "rss.xml");
+      write_rss(rss, args, branch, absolute);
+    }
+
+    state.mfst.write();
+  }
+
+  write_summary(job);
+  job.meta.write();
+}
+
+void finish_repository(
+    scheduler& sched, const std::shared_ptr<repository_job>& job
+)
+{
+  if (--job->pending != 0) {
+    return;
+  }
+
+  // the indexes share the objects of the repository's own handle,
+  // so they are written together by a single task
+  const auto cost = job->rendered.size() + job->states.size();
+  sched.submit(
+      [job](auto& /* wrk */)
+      { report(job->repo.get_path(), [&]() { write_indexes(*job); }); },
+      cost
+  );
+}
+
+void write_repository(
+    scheduler& sched,
+    const arguments_t& args,
+    const std::filesystem::path& path
+)
+{
+  const auto job = std::make_shared<repository_job>(args, path);
+  const auto& repo = job->repo;
+  const auto& base = job->base;
+  const auto& store = job->store;
+
+  std::filesystem::create_directory(base);
+  std::filesystem::create_directory(store);
+
+  const spawn_t spawn = [&sched, job](page_task task, std::size_t cost)
+  {
+    ++job->pending;
+    sched.submit(
+        [&sched, job, task = std::move(task)](auto& wrk)
+        {
+          const auto& path = job->repo.get_path();
+          report(path, [&]() { task(wrk.get_repository(path)); });
+          finish_repository(sched, job);
+        },
+        cost
+    );
   };
+
+  // decide what changed from the refs alone, before any history is walked
+  const auto refs = repo.get_refs();
+  const auto& branch_refs = repo.get_branch_refs();
+  std::unordered_set<std::string> moved;
+
+  job->states.reserve(branch_refs.size());
+  for (const auto& ref : branch_refs) {
+    const std::filesystem::path base_branch = base / ref.name;
+    std::filesystem::create_directory(base_branch);
+
+    auto& state = job->states.emplace_back(
+        base_branch, manifest(base_branch / ".manifest")
+    );
+    auto& mfst = state.mfst;
+
+    if (args.force || mfst.get_refs() != refs) {
+      write_refs(base_branch, repo, ref);
+      mfst.set_refs(refs);
+      state.refs_changed = true;
+    }
+
+    if (args.force || mfst.get_tip() != ref.tip.get_hex_string(40)) {  // NOLINT
+      moved.insert(ref.name);
+      state.tip_changed = true;
+    }
+  }
+
+  const bool changed = std::ranges::any_of(
+      job->states,
+      [](const auto& state) { return state.refs_changed || state.tip_changed; }
+  );
+
+  // nothing to redo, leave the repository without building any branch
+  if (!changed && std::filesystem::exists(base / ".summary")) {
+    return;
+  }
+
+  // branches come in the order of their refs, so they line up with states
+  const auto& branches = repo.get_branches(moved);
+  auto next = branches.begin();
+
+  for (auto& state : job->states) {
+    if (!state.tip_changed) {
+      continue;
+    }
+
+    const auto& branch = *next++;
+    state.brnch = &branch;
+
+    auto& mfst = state.mfst;
+    const auto& base_branch = state.base;
+
+    const std::filesystem::path commit = base_branch / "commit";
+    std::filesystem::create_directory(commit);
+
+    // hide everything rendered by the previous run
+    const auto& last = branch.get_last_commit();
+    branch.walk_commits_since(
+        args.force ? "" : mfst.get_tip(),
+        [&](const auto& cmmt)
+        {
+          write_commit(
+              spawn,
+              store,
+              commit,
+              repo,
+              job->meta,
+              cmmt,
+              job->rendered,
+              job->links
+          );
+        }
+    );
+
+    if (args.force || mfst.get_tree() != last.get_tree_id()) {
+      write_special(spawn, base_branch, repo, branch);
+
+      const std::filesystem::path file = base_branch / "file";
+      std::filesystem::create_directory(file);
+
+      // only touch the pages of blobs that changed since the last run
+      const auto changes = get_tree_changes(repo, mfst.get_tree(), last);
+      collect_files(job->files, file, branch, changes ? &*changes : nullptr);
+      state.tree_changed = true;
+    }
+
+    mfst.set_tip(last.get_id());
+    mfst.set_tree(last.get_tree_id());
+  }
+
+  // pages of a blob shared by many branches are written together
+  write_files(spawn, repo, job->files);
+  finish_repository(sched, job);
 }
 
 }  // namespace startgit
@@ -681,9 +1589,13 @@ int main(int argc, const char* argv[])
   using namespace startgit;  // NOLINT
   using namespace poafloc;  // NOLINT
 
+  arguments_t args;
   auto program = parser<arguments_t> {
       positional {
-          argument {"repository", &arguments_t::set_repository},
+          argument_list {
+              "repositories",
+              &arguments_t::set_repository,
+          },
       },
       group {
           "Output mode",
@@ -695,13 +1607,63 @@ int main(int argc, const char* argv[])
           boolean {
               "f force",
               &arguments_t::force,
-              "Force write even if file exists",
+              "Force write even if nothing has changed",
           },
           list {
               "s special",
               &arguments_t::add_special,
               "FILE Files to be rendered to html",
           },
+          direct {
+              "c cache",
+              &arguments_t::set_diff_cache,
+              "SIZE Budget for cached diff stats in MiB",
+          },
+          direct {
+              "M memory-budget",
+              &arguments_t::set_memory_budget,
+              "SIZE Memory for libgit2 and diff stats caches in MiB",
+          },
+          direct {
+              "B diff-blob",
+              &arguments_t::set_diff_blob,
+              "SIZE Largest blob to diff in KiB",
+          },
+          direct {
+              "L diff-lines",
+              &arguments_t::set_diff_lines,
+              "N Most changed lines shown for one file",
+          },
+          direct {
+              "F diff-files",
+              &arguments_t::set_diff_files,
+              "N Most files shown in full on a commit page",
+          },
+          direct {
+              "P diff-page",
+              &arguments_t::set_diff_page,
+              "SIZE Largest diff output on a commit page in MiB",
+          },
+          direct {
+              "S file-size",
+              &arguments_t::set_file_size,
+              "SIZE Largest file shown in full in KiB",
+          },
+          direct {
+              "C file-chunk",
+              &arguments_t::set_file_chunk,
+              "N Split larger files into pages of N lines",
+          },
+          boolean {
+              "G commit-graph",
+              &arguments_t::commit_graph,
+              "Write or refresh the commit-graph of each repository",
+          },
+          direct {
+              "j jobs",
+              &arguments_t::set_jobs,
+              "N Number of worker threads",
+          },
           direct {
               "g github",
               &arguments_t::github,
@@ -744,63 +1706,54 @@ int main(int argc, const char* argv[])
       return -1;
     }
 
+    // each repository writes into a directory named after it,
+    // two with the same name would overwrite each other's pages
+    std::unordered_set<std::string> names;
+    for (const auto& path : args.repos) {
+      if (!names.insert(path.stem().string()).second) {
+        throw std::runtime_error(std::format(
+            "{}: another repository is also named {}",
+            path.string(),
+            path.stem().string()
+        ));
+      }
+    }
+
     const git2wrap::libgit2 libgit;
 
     auto& output_dir = args.output_dir;
     std::filesystem::create_directories(output_dir);
     output_dir = std::filesystem::canonical(output_dir);
 
-    const repository repo(args.repos.front());
-    const std::filesystem::path base = args.output_dir / repo.get_name();
-    std::filesystem::create_directory(base);
-
-    for (const auto& branch : repo.get_branches()) {
-      const std::filesystem::path base_branch = base / branch.get_name();
-      std::filesystem::create_directory(base_branch);
-
-      const std::filesystem::path commit = base_branch / "commit";
-      std::filesystem::create_directory(commit);
-
-      // always update refs in case of a new branch or tag
-      write_refs(base_branch, repo, branch);
-
-      const bool changed = write_commits(commit, repo, branch);
-      if (!args.force && !changed) {
-        continue;
-      };
-
-      write_log(base_branch, repo, branch);
-      write_file(base_branch, repo, branch);
-      write_special(base_branch, repo, branch);
-
-      const std::filesystem::path file = base_branch / "file";
-      std::filesystem::create_directory(file);
-
-      write_files(file, repo, branch);
+    set_memory_budget(args);
+    diff_cache().set_budget(args.diff_cache);
 
-      const std::string relative =
-          std::filesystem::relative(base_branch, args.output_dir);
-      const auto absolute = "https://git.dimitrijedobrota.com/" + relative;
-
-      std::ofstream atom(base_branch / "atom.xml");
-      write_atom(atom, branch, absolute);
+    // repositories, branches and pages all share the same workers
+    scheduler sched(args.jobs);
+    for (const auto& path : args.repos) {
+      sched.submit(
+          [&sched, &args, path](auto& /* wrk */)
+          { report(path, [&]() { write_repository(sched, args, path); }); },
+          estimate_cost(path)
+      );
+    }
+    sched.wait();
 
-      std::ofstream rss(base_branch / "rss.xml");
-      write_rss(rss, branch, absolute);
+    if (failed()) {
+      return 1;
     }
-  } catch (const git2wrap::error<git2wrap::error_code_t::enotfound>& err) {
-    std::cerr << std::format(
-        "Warning: {} is not a repository\n", args.repos.front().string()
-    );
   } catch (const poafloc::runtime_error& err) {
     std::cerr << std::format("Error (poafloc): {}\n", err.what());
     return 1;
   } catch (const git2wrap::runtime_error& err) {
     std::cerr << std::format("Error (git2wrap): {}\n", err.what());
+    return 1;
   } catch (const std::runtime_error& err) {
     std::cerr << std::format("Error: {}\n", err.what());
+    return 1;
   } catch (...) {
     std::cerr << std::format("Unknown error\n");
+    return 1;
   }
 
   return 0;
@@ -0,0 +1,92 @@
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "summary.hpp"
+
+namespace startgit
+{
+
+summary::summary(std::filesystem::path path)
+    : m_path(std::move(path))
+{
+  std::ifstream ifs(m_path);
+
+  std::string line;
+  while (std::getline(ifs, line)) {
+    const auto pos = line.find(' ');
+    if (pos == std::string::npos) {
+      continue;
+    }
+
+    const auto key = line.substr(0, pos);
+    auto value = line.substr(pos + 1);
+
+    if (key == "name") {
+      m_name = std::move(value);
+    } else if (key == "url") {
+      m_url = std::move(value);
+    } else if (key == "owner") {
+      m_owner = std::move(value);
+    } else if (key == "description") {
+      m_description = std::move(value);
+    } else if (key == "branch") {
+      std::istringstream iss(value);
+
+      branch_info info = {};
+      if (iss >> info.name >> info.tip >> info.time >> info.commits) {
+        m_branches.push_back(std::move(info));
+      }
+    }
+  }
+}
+
+const summary::branch_info* summary::get_branch(const std::string& name) const
+{
+  for (const auto& info : m_branches) {
+    if (info.name == name) {
+      return &info;
+    }
+  }
+
+  return nullptr;
+}
+
+std::string summary::str() const
+{
+  std::ostringstream oss;
+
+  oss << "name " << m_name << '\n';
+  oss << "url " << m_url << '\n';
+  oss << "owner " << m_owner << '\n';
+  oss << "description " << m_description << '\n';
+
+  for (const auto& info : m_branches) {
+    oss << "branch " << info.name << ' ' << info.tip << ' ' << info.time << ' '
+        << info.commits << '\n';
+  }
+
+  return oss.str();
+}
+
+bool summary::write() const
+{
+  const auto content = str();
+
+  {
+    std::ifstream ifs(m_path);
+    const std::string old(
+        (std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()
+    );
+
+    if (old == content) {
+      return false;
+    }
+  }
+
+  std::ofstream ofs(m_path);
+  ofs << content;
+  return true;
+}
+
+}  // namespace startgit
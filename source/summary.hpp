@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace startgit
+{
+
+// What the index needs to know about a rendered repository, kept next to
+// its pages so startgit-index never has to open the repository itself.
+class summary
+{
+public:
+  struct branch_info
+  {
+    std::string name;
+    std::string tip;
+    std::int64_t time;
+    std::size_t commits;
+  };
+
+  explicit summary(std::filesystem::path path);
+
+  // false if the file is missing or was never written
+  bool is_valid() const { return !m_name.empty(); }
+
+  const std::string& get_name() const { return m_name; }
+  const std::string& get_url() const { return m_url; }
+  const std::string& get_owner() const { return m_owner; }
+  const std::string& get_description() const { return m_description; }
+  const auto& get_branches() const { return m_branches; }
+
+  // nullptr if there is no branch with the given name
+  const branch_info* get_branch(const std::string& name) const;
+
+  void set_name(std::string name) { m_name = std::move(name); }
+  void set_url(std::string url) { m_url = std::move(url); }
+  void set_owner(std::string owner) { m_owner = std::move(owner); }
+  void set_description(std::string desc) { m_description = std::move(desc); }
+
+  // replaces whatever was read from the file
+  void set_branches(std::vector<branch_info> branches)
+  {
+    m_branches = std::move(branches);
+  }
+
+  // the file is only rewritten when its contents change
+  bool write() const;
+
+private:
+  std::string str() const;
+
+  std::filesystem::path m_path;
+
+  std::string m_name;
+  std::string m_url;
+  std::string m_owner;
+  std::string m_description;
+  std::vector<branch_info> m_branches;
+};
+
+}  // namespace startgit
@@ -1,3 +1,5 @@
+#include <array>
+#include <bit>
 #include <chrono>
 #include <format>
 
@@ -5,6 +7,10 @@
 
 #include <sys/stat.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
 namespace startgit
 {
 
@@ -31,26 +37,145 @@ std::string time_long(const git2wrap::time& time)
       time.offset % 60  // NOLINT
   );
 }
+
+namespace
+{
+
+constexpr const std::array<bool, 256> escape_map = []()
+{
+  std::array<bool, 256> res = {};
+  for (const char chr : std::string_view("<>&\"'\n")) {
+    res[static_cast<unsigned char>(chr)] = true;  // NOLINT
+  }
+  return res;
+}();
+
+#if defined(__AVX2__)
+bool find_escape_avx2(const char* data, std::size_t size, std::size_t& off)
+{
+  const auto cmp = [](__m256i chunk, char chr)
+  { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(chr)); };
+
+  for (; off + 32 <= size; off += 32) {
+    const auto chunk = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + off)  // NOLINT
+    );
+
+    const auto hit = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_or_si256(cmp(chunk, '<'), cmp(chunk, '>')),
+            _mm256_or_si256(cmp(chunk, '&'), cmp(chunk, '"'))
+        ),
+        _mm256_or_si256(cmp(chunk, '\''), cmp(chunk, '\n'))
+    );
+
+    const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+    if (mask != 0) {
+      off += static_cast<std::size_t>(std::countr_zero(mask));
+      return true;
+    }
+  }
+
+  return false;
+}
+#endif
+
+#if defined(__SSE2__)
+bool find_escape_sse2(const char* data, std::size_t size, std::size_t& off)
+{
+  const auto cmp = [](__m128i chunk, char chr)
+  { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(chr)); };
+
+  for (; off + 16 <= size; off += 16) {
+    const auto chunk = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + off)  // NOLINT
+    );
+
+    const auto hit = _mm_or_si128(
+        _mm_or_si128(
+            _mm_or_si128(cmp(chunk, '<'), cmp(chunk, '>')),
+            _mm_or_si128(cmp(chunk, '&'), cmp(chunk, '"'))
+        ),
+        _mm_or_si128(cmp(chunk, '\''), cmp(chunk, '\n'))
+    );
+
+    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+    if (mask != 0) {
+      off += static_cast<std::size_t>(std::countr_zero(mask));
+      return true;
+    }
+  }
+
+  return false;
+}
+#endif
+
+}  // namespace
+
+std::size_t find_escape(std::string_view str)
+{
+  const char* data = str.data();
+  const std::size_t size = str.size();
+  std::size_t off = 0;
+
+  // vector kernels stop at the first hit or before a partial block,
+  // whatever is left over is finished one byte at a time
+#if defined(__AVX2__)
+  if (find_escape_avx2(data, size, off)) {
+    return off;
+  }
+#endif
+
+#if defined(__SSE2__)
+  if (find_escape_sse2(data, size, off)) {
+    return off;
+  }
+#endif
+
+  while (off < size && !escape_map[static_cast<unsigned char>(data[off])]) {
+    off++;
+  }
+
+  return off;
+}
+
+void xmlencode(std::string& out, std::string_view str)
+{
+  out.reserve(out.size() + str.size());
+
+  while (!str.empty()) {
+    const auto off = find_escape(str);
+    out.append(str.data(), off);
+
+    if (off == str.size()) {
+      break;
+    }
+
+    out += escape_entity(str[off]);
+    str.remove_prefix(off + 1);
+  }
+}
+
 // NOLINTBEGIN
 // clang-format off
 
-std::string xmlencode(const std::string& str)
+std::string_view escape_entity(char chr)
 {
-    std::string res;
-
-    res.reserve(str.size());
-    for (const char c: str) {
-        switch(c) {
-        case '<':  res += "&lt;"; continue;
-        case '>':  res += "&gt;"; continue;
-        case '\'': res += "&#39;"; continue;
-        case '&':  res += "&amp;"; continue;
-        case '"':  res += "&quot;"; continue;
-        case '\n': res += "<br>"; continue;
-        }
-        res += c;
+    switch(chr) {
+    case '<':  return "&lt;";
+    case '>':  return "&gt;";
+    case '\'': return "&#39;";
+    case '&':  return "&amp;";
+    case '"':  return "&quot;";
+    case '\n': return "<br>";
     }
+    return {};
+}
 
+std::string xmlencode(const std::string& str)
+{
+    std::string res;
+    xmlencode(res, str);
     return res;
 }
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <ostream>
 #include <string>
+#include <string_view>
 
 #include <git2wrap/types.hpp>
 
@@ -12,6 +14,13 @@ std::string time_short(int64_t date);
 std::string time_long(const git2wrap::time& time);
 void xmlencode(std::ostream& ost, const std::string& str);
 std::string xmlencode(const std::string& str);
+
+// appends to the end of out, so one buffer can be reused for many strings
+void xmlencode(std::string& out, std::string_view str);
+
+// offset of the first character that needs escaping, str.size() if none
+std::size_t find_escape(std::string_view str);
+std::string_view escape_entity(char chr);
 std::string filemode(git2wrap::filemode_t filemode);
 
 }  // namespace startgit
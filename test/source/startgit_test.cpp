@@ -1,4 +1,448 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "commit_graph.hpp"
+#include "metadata.hpp"
+#include "summary.hpp"
+#include "utils.hpp"
+
+namespace
+{
+
+// write, read back and write again: the file must be stable across runs
+// and always reflect the branches of the latest run
+bool summary_round_trip()
+{
+  using startgit::summary;
+
+  const auto path =
+      std::filesystem::temp_directory_path() / "startgit_test.summary";
+  std::filesystem::remove(path);
+
+  const auto run = [&](std::int64_t time)
+  {
+    summary smry(path);
+    smry.set_name("repo");
+    smry.set_description("a repository");
+    smry.set_branches({{"master", "abc", time, 3}});
+    return smry.write();
+  };
+
+  const bool first = run(1);
+  const bool same = run(1);
+  const bool moved = run(2);
+
+  const summary read(path);
+  const auto* master = read.get_branch("master");
+
+  std::filesystem::remove(path);
+
+  return first && !same && moved && read.get_branches().size() == 1
+      && master != nullptr && master->time == 2;
+}
+
+git2wrap::oid make_oid(unsigned char seed)
+{
+  git_oid raw = {};
+  raw.id[0] = seed;  // NOLINT
+  return git2wrap::oid(&raw);
+}
+
+// records written by one run are read back by the next, a record cut
+// short by an interrupted run is dropped, and a different diff limit
+// starts the file over
+bool metadata_round_trip()
+{
+  using startgit::metadata;
+
+  const auto path =
+      std::filesystem::temp_directory_path() / "startgit_test.metadata";
+  std::filesystem::remove(path);
+
+  std::uintmax_t one = 0;
+  std::uintmax_t two = 0;
+
+  {
+    metadata meta(path, 1);
+    meta.put_commit(make_oid(1), {1, 2, 3});
+    meta.write();
+    one = std::filesystem::file_size(path);
+
+    meta.put_blob(make_oid(2), {100, 10, false, true});  // NOLINT
+    meta.write();
+    two = std::filesystem::file_size(path);
+  }
+
+  const auto record = two - one;
+
+  const auto check = [&](const metadata& meta)
+  {
+    const auto stats = meta.get_commit(make_oid(1));
+    const auto info = meta.get_blob(make_oid(2));
+
+    return stats && stats->files == 1 && stats->insertions == 2
+        && stats->deletions == 3 && info && info->size == 100
+        && info->lines == 10 && !info->binary && info->counted
+        && !meta.get_blob(make_oid(1));
+  };
+
+  bool res = true;
+
+  {
+    const metadata meta(path, 1);
+    res = res && check(meta) && !meta.get_commit(make_oid(3));
+  }
+
+  {
+    std::ofstream ofs(path, std::ios::binary | std::ios::app);
+    ofs << "partial";
+  }
+
+  {
+    metadata meta(path, 1);
+    res = res && check(meta);
+
+    meta.put_commit(make_oid(3), {4, 5, 6});  // NOLINT
+    meta.write();
+    res = res && std::filesystem::file_size(path) == two + record;
+  }
+
+  {
+    const metadata meta(path, 1);
+    const auto stats = meta.get_commit(make_oid(3));
+    res = res && check(meta) && stats && stats->deletions == 6;
+  }
+
+  {
+    metadata meta(path, 2);
+    res = res && !meta.get_commit(make_oid(1));
+
+    meta.put_commit(make_oid(1), {1, 2, 3});
+    meta.write();
+    res = res && std::filesystem::file_size(path) == one;
+  }
+
+  std::filesystem::remove(path);
+  return res;
+}
+
+void put32(std::string& buf, std::uint32_t val)
+{
+  for (const unsigned shift : {24U, 16U, 8U, 0U}) {  // NOLINT
+    buf.push_back(static_cast<char>((val >> shift) & 0xffU));  // NOLINT
+  }
+}
+
+void put64(std::string& buf, std::uint64_t val)
+{
+  put32(buf, static_cast<std::uint32_t>(val >> 32U));  // NOLINT
+  put32(buf, static_cast<std::uint32_t>(val));
+}
+
+// A graph of four commits, the ids of make_oid(1) to make_oid(4):
+// 1 is the root, 2 its child, 3 merges 2 and 1 and 4 is an octopus
+// merge of 1, 2 and 3 with the rest of its parents in the edge chunk.
+struct graph_file
+{
+  static constexpr std::uint32_t none = 0x70000000;
+  static constexpr std::uint32_t extra = 0x80000000;
+
+  std::vector<std::uint32_t> fanout;
+  std::vector<std::array<std::uint32_t, 2>> parents = {
+      {none, none},
+      {0, none},
+      {1, 0},
+      {0, extra | 0},
+  };
+  std::vector<std::uint64_t> times = {100, 200, 0x100000005, 400};  // NOLINT
+  std::vector<std::uint32_t> edges = {1, extra | 2};
+
+  graph_file()
+  {
+    // commit k has its first byte set to k, counts are cumulative
+    for (std::uint32_t byte = 0; byte < 256; byte++) {  // NOLINT
+      fanout.push_back(std::min(byte, 4U));
+    }
+  }
+
+  std::string build() const
+  {
+    std::string fanout_chunk;
+    for (const auto val : fanout) {
+      put32(fanout_chunk, val);
+    }
+
+    std::string oids;
+    std::string data;
+    for (std::size_t i = 0; i < parents.size(); i++) {
+      const auto idd = make_oid(static_cast<unsigned char>(i + 1));
+      oids.append(reinterpret_cast<const char*>(idd.ptr()->id), 20);  // NOLINT
+      data.append(20, '\0');  // tree
+      put32(data, parents[i][0]);
+      put32(data, parents[i][1]);
+      put64(data, (std::uint64_t {1} << 34U) | times[i]);  // NOLINT
+    }
+
+    std::string edge_chunk;
+    for (const auto val : edges) {
+      put32(edge_chunk, val);
+    }
+
+    const std::vector<std::pair<std::uint32_t, const std::string*>> chunks = {
+        {0x4f494446, &fanout_chunk},  // NOLINT OIDF
+        {0x4f49444c, &oids},  // NOLINT OIDL
+        {0x43444154, &data},  // NOLINT CDAT
+        {0x45444745, &edge_chunk},  // NOLINT EDGE
+    };
+
+    std::string res = "CGPH";
+    res.push_back(1);  // version
+    res.push_back(1);  // sha1
+    res.push_back(static_cast<char>(chunks.size()));
+    res.push_back(0);  // base graphs
+
+    auto offset = res.size() + ((chunks.size() + 1) * 12);  // NOLINT
+    for (const auto& [sig, chunk] : chunks) {
+      put32(res, sig);
+      put64(res, offset);
+      offset += chunk->size();
+    }
+    put32(res, 0);
+    put64(res, offset);
+
+    for (const auto& chunk : chunks) {
+      res += *chunk.second;
+    }
+
+    return res;
+  }
+};
+
+// load a graph from bytes, the way it would be found in objects/info
+template<typename F>
+bool with_graph(const std::string& bytes, F func)
+{
+  const auto dir =
+      std::filesystem::temp_directory_path() / "startgit_test.graph";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directory(dir);
+
+  {
+    std::ofstream ofs(dir / "commit-graph", std::ios::binary);
+    ofs << bytes;
+  }
+
+  bool res = false;
+  {
+    const startgit::commit_graph graph(dir);
+    res = func(graph);
+  }
+
+  std::filesystem::remove_all(dir);
+  return res;
+}
+
+bool is_empty(const startgit::commit_graph& graph)
+{
+  for (unsigned char seed = 0; seed <= 5; seed++) {  // NOLINT
+    if (graph.find(make_oid(seed))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// lookups, times and parents, including the ones in the edge chunk
+bool commit_graph_read()
+{
+  return with_graph(
+      graph_file().build(),
+      [](const auto& graph)
+      {
+        using list = std::vector<std::uint32_t>;
+        const auto parents = [&](std::uint32_t pos, const list& expected)
+        {
+          list out;
+          return graph.get_parents(pos, out) && out == expected;
+        };
+
+        for (std::uint32_t pos = 0; pos < 4; pos++) {
+          const auto idd = make_oid(static_cast<unsigned char>(pos + 1));
+          const auto found = graph.get_id(pos);
+          if (graph.find(idd) != pos
+              || std::memcmp(found.ptr()->id, idd.ptr()->id, 20) != 0)
+          {
+            return false;
+          }
+        }
+
+        return !graph.find(make_oid(0)) && !graph.find(make_oid(5))
+            && graph.get_time(0) == 100 && graph.get_time(2) == 0x100000005
+            && parents(0, {}) && parents(1, {0}) && parents(2, {1, 0})
+            && parents(3, {0, 1, 2});
+      }
+  );
+}
+
+// a damaged graph is either dropped whole or its parents refused,
+// nothing is ever read from outside of the file
+bool commit_graph_reject()
+{
+  const auto full = graph_file().build();
+
+  // cut anywhere, including inside the header and the chunk table
+  for (std::size_t size = 0; size < full.size(); size++) {
+    if (!with_graph(full.substr(0, size), is_empty)) {
+      return false;
+    }
+  }
+
+  graph_file fanout;
+  fanout.fanout[2] = 4;
+  if (!with_graph(fanout.build(), is_empty)) {
+    return false;
+  }
+
+  graph_file past;
+  past.fanout.back() = 5;  // NOLINT
+  if (!with_graph(past.build(), is_empty)) {
+    return false;
+  }
+
+  const auto refused = [](const graph_file& file, std::uint32_t pos)
+  {
+    return with_graph(
+        file.build(),
+        [&](const auto& graph)
+        {
+          std::vector<std::uint32_t> out;
+          return graph.find(make_oid(1)) && !graph.get_parents(pos, out);
+        }
+    );
+  };
+
+  graph_file parent;
+  parent.parents[1][0] = 4;
+  graph_file second;
+  second.parents[2][1] = 7;  // NOLINT
+  graph_file edge;
+  edge.parents[3][1] = graph_file::extra | 2;
+  graph_file open;
+  open.edges.back() = 2;
+  graph_file edge_parent;
+  edge_parent.edges.back() = graph_file::extra | 4;
+
+  return refused(parent, 1) && refused(second, 2) && refused(edge, 3)
+      && refused(open, 3) && refused(edge_parent, 3);
+}
+
+// the scalar path of find_escape, one byte at a time
+std::size_t find_escape_scalar(std::string_view str)
+{
+  std::size_t off = 0;
+  while (off < str.size() && startgit::escape_entity(str[off]).empty()) {
+    off++;
+  }
+  return off;
+}
+
+// a character to escape at every position of inputs up to a few 32 byte
+// blocks long: at the edges of 16 and 32 byte blocks, in the tail after
+// the last full block, and in inputs shorter than a block
+bool find_escape_blocks()
+{
+  using startgit::find_escape;
+
+  static constexpr std::size_t max_size = 100;
+
+  for (std::size_t size = 0; size <= max_size; size++) {
+    const std::string plain(size, 'a');
+    if (find_escape(plain) != size || find_escape_scalar(plain) != size) {
+      return false;
+    }
+
+    for (const char chr : std::string_view("<>&\"'\n")) {
+      for (std::size_t pos = 0; pos < size; pos++) {
+        std::string str = plain;
+        str[pos] = chr;
+
+        // a second hit further on must not be reported instead
+        if (pos + 1 < size) {
+          str.back() = chr;
+        }
+
+        if (find_escape(str) != pos || find_escape_scalar(str) != pos) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+// every byte value in a full block and in the tail, also off alignment
+bool find_escape_bytes()
+{
+  using startgit::find_escape;
+
+  for (std::size_t value = 0; value < 256; value++) {  // NOLINT
+    for (const std::size_t pos : {0, 15, 16, 31, 32, 33, 47, 63}) {
+      std::string str(64 + 1, 'a');  // NOLINT
+      str[pos + 1] = static_cast<char>(value);
+
+      const auto view = std::string_view(str).substr(1);
+      if (find_escape(view) != find_escape_scalar(view)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
 int main()
 {
+  if (!summary_round_trip()) {
+    std::cerr << "summary round trip failed\n";
+    return 1;
+  }
+
+  if (!metadata_round_trip()) {
+    std::cerr << "metadata round trip failed\n";
+    return 1;
+  }
+
+  if (!commit_graph_read()) {
+    std::cerr << "commit graph read failed\n";
+    return 1;
+  }
+
+  if (!commit_graph_reject()) {
+    std::cerr << "commit graph accepted a damaged file\n";
+    return 1;
+  }
+
+  if (!find_escape_blocks()) {
+    std::cerr << "find_escape disagrees at a block edge\n";
+    return 1;
+  }
+
+  if (!find_escape_bytes()) {
+    std::cerr << "find_escape disagrees on a byte value\n";
+    return 1;
+  }
+
   return 0;
 }